@@ -1,23 +1,41 @@
 """The fast_ctd package."""
 
 from fast_ctd.tools import (
+    ImprintStatus,
+    IntersectStatus,
+    MergeCancelled,
+    benchmark_merge_engines,
+    check_brep_overlaps,
     check_watertight,
     dagmc_to_vtk,
     decode_tightness_checks,
+    detect_brep_merges,
     facet_brep_to_dagmc,
+    fix_brep_overlaps,
     make_watertight,
     merge_brep_geometries,
+    merge_brep_geometries_incremental,
     step_to_brep,
+    sweep_merge_tolerances,
     validate_dagmc_model_using_openmc,
 )
 
 __all__ = [
+    "ImprintStatus",
+    "IntersectStatus",
+    "MergeCancelled",
+    "benchmark_merge_engines",
+    "check_brep_overlaps",
     "check_watertight",
     "dagmc_to_vtk",
     "decode_tightness_checks",
+    "detect_brep_merges",
     "facet_brep_to_dagmc",
+    "fix_brep_overlaps",
     "make_watertight",
     "merge_brep_geometries",
+    "merge_brep_geometries_incremental",
     "step_to_brep",
+    "sweep_merge_tolerances",
     "validate_dagmc_model_using_openmc",
 ]
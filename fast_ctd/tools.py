@@ -6,9 +6,30 @@ It provides tooling around the API, such as default values, input validation and
 import re
 import subprocess as sp
 import sys
+from collections.abc import Callable
 from pathlib import Path
 
-from fast_ctd_ext import occ_faceter, occ_merger, occ_step_to_brep
+from fast_ctd_ext import (
+    GlueDetection,
+    GlueStats,
+    ImprintStatus,
+    IntersectStatus,
+    MergeBenchmark,
+    MergeCancelled,
+    MergeOptions,
+    OverlapFix,
+    OverlapPair,
+    check_merge_options,
+    occ_faceter,
+    occ_merger,
+    occ_merger_benchmark,
+    occ_merger_detect,
+    occ_merger_incremental,
+    occ_merger_sweep,
+    occ_overlap_checker,
+    occ_overlap_fixer,
+    occ_step_to_brep,
+)
 
 from fast_ctd.utils import none_guard, validate_file_exists, validate_file_extension
 
@@ -93,8 +114,18 @@ def merge_brep_geometries(
     output_brep_file: StrPath,
     *,
     dist_tolerance: float = 0.001,
+    partitioned: bool = False,
+    groups: list[int | str] | None = None,
+    imprint: bool = False,
+    mesh_solids: list[int] | None = None,
+    mesh_fallback: bool = False,
+    cross_solid_only: bool = False,
+    near_miss_tolerance: float | None = None,
+    engine: str = "salome",
+    time_limit: float | None = None,
+    progress: Callable[[str, float], bool | None] | None = None,
     enable_logging: bool = False,
-) -> None:
+) -> GlueStats:
     """Merge vertices in a BREP file and save the result to a new BREP file.
 
     Args:
@@ -103,7 +134,71 @@ def merge_brep_geometries(
         dist_tolerance:
             The distance tolerance for merging entities
             (vertices, edges, faces, etc.).
+        partitioned:
+            Split the solids into clusters whose bounding boxes overlap
+            (within `dist_tolerance`) and merge each cluster concurrently.
+            Solids that are not near any other solid are left untouched.
+        groups:
+            The group of each solid, e.g. the component group numbers returned
+            by `step_to_brep`. Solids are merged within each group
+            concurrently, then only the solids near another group are merged
+            across groups. Those solids are searched whole in the second
+            pass, so little is saved when most solids border another group.
+            Can't be combined with `partitioned`.
+        imprint:
+            Before merging, split faces of touching solids that only partly
+            coincide, so the interfaces between them become conformal.
+            Each cluster of touching solids is imprinted separately.
+        mesh_solids:
+            Indices of solids whose clusters (as for `partitioned`) are not
+            merged, e.g. because merging them is too slow. They are listed in
+            the returned `mesh_solids`, to be passed to `facet_brep_to_dagmc`
+            which makes their interfaces conformal after faceting.
+            Implies `partitioned`.
+        mesh_fallback:
+            Leave clusters that fail to merge unmerged, and list their solids
+            in the returned `mesh_solids`, rather than failing.
+            Implies `partitioned`.
+        cross_solid_only:
+            Only merge vertices, edges and faces of different solids. Faster,
+            as nothing is searched for within a solid or around solids with
+            no neighbours, but coincident entities inside one solid are left
+            as they are. Can't be combined with `groups`.
+        near_miss_tolerance:
+            When larger than `dist_tolerance`, search the merged result for
+            pairs of vertices, edges and faces of different solids closer
+            than this that were not merged, and don't already share a vertex,
+            and list them in the returned `near_misses` with the tolerance
+            that would merge them, their solids and positions. Costs one
+            extra (parallel) search out to this distance after merging,
+            which counts towards `time_limit` and can be cancelled through
+            `progress`. Useful for choosing a tolerance that closes the
+            gaps. Can't be combined with `groups`.
+        engine:
+            `"salome"` for the gluer, or `"fuse"` to general fuse all the
+            solids at once (in parallel) instead, which also makes partly
+            coincident faces conformal. The fuse engine can't be combined
+            with any of the options above. `benchmark_merge_engines` compares
+            the two on a model.
+        time_limit:
+            The maximum time in seconds to spend gluing, `None` for no limit.
+            Loading the model doesn't count towards it.
+        progress:
+            Called periodically (possibly from a worker thread) with the name
+            of the current phase and the fraction of the merge done.
+            Returning `False` cancels the merge. An exception raised by it
+            also cancels the merge, and is raised from here.
         enable_logging: Whether to enable logging in the C++ extension code.
+
+    Returns:
+        The wall time and memory use of each phase of the merge, the peak
+        memory use, counts of the work done (vertex clusters, bucket
+        sizes, projections and closed form checks, glued edges and faces),
+        the solids left for merging in mesh space, and the near misses.
+
+    Raises:
+        MergeCancelled: If the time limit expired or `progress` returned `False`.
+            No output file is written.
     """
     input_brep_file = Path(input_brep_file)
     output_brep_file = Path(output_brep_file)
@@ -112,13 +207,370 @@ def merge_brep_geometries(
     validate_file_exists(input_brep_file)
     validate_file_extension(output_brep_file, ".brep")
 
+    options = MergeOptions()
+    options.dist_tolerance = none_guard(dist_tolerance, 0.001)
+    options.engine = none_guard(engine, "salome")
+    options.partitioned = none_guard(partitioned, False)  # noqa: FBT003
+    options.groups = [int(group) for group in none_guard(groups, [])]
+    options.imprint = none_guard(imprint, False)  # noqa: FBT003
+    options.mesh_solids = none_guard(mesh_solids, [])
+    options.mesh_fallback = none_guard(mesh_fallback, False)  # noqa: FBT003
+    options.cross_solid_only = none_guard(cross_solid_only, False)  # noqa: FBT003
+    options.near_miss_tolerance = none_guard(near_miss_tolerance, 0.0)
+    options.time_limit_secs = none_guard(time_limit, 0.0)
+    # the combinations allowed are checked in C++, which would exit instead
+    invalid = check_merge_options(options)
+    if invalid:
+        raise ValueError(invalid[0].upper() + invalid[1:])
+
+    progress_callback = None
+    if progress is not None:
+
+        def progress_callback(phase: str, fraction: float) -> bool:
+            return progress(phase, fraction) is not False
+
+    return occ_merger(
+        input_brep_file.as_posix(),
+        output_brep_file.as_posix(),
+        options,
+        progress_callback=progress_callback,
+        logging=enable_logging,
+    )
+
+
+def benchmark_merge_engines(
+    input_brep_file: StrPath,
+    *,
+    dist_tolerance: float = 0.001,
+    enable_logging: bool = False,
+) -> list[MergeBenchmark]:
+    """Merge a BREP file with each merge engine, to choose the faster one.
+
+    The gluer (`"salome"`) and then the general fuse (`"fuse"`) engines of
+    `merge_brep_geometries` are run on the same input. Nothing is written.
+
+    Args:
+        input_brep_file: The path to the input BREP file.
+        dist_tolerance:
+            The distance tolerance for merging entities
+            (vertices, edges, faces, etc.).
+        enable_logging: Whether to enable logging in the C++ extension code.
+
+    Returns:
+        For each engine, its wall time and memory use, whether its result kept
+        the solids and their volumes, and its stats with the counts of glued
+        vertices, edges and faces. An engine that fails to merge is reported
+        as not passing rather than ending the benchmark.
+    """
+    input_brep_file = Path(input_brep_file)
+
+    validate_file_extension(input_brep_file, ".brep")
+    validate_file_exists(input_brep_file)
+
     dist_tolerance = none_guard(dist_tolerance, 0.001)
 
-    occ_merger(
+    return occ_merger_benchmark(
+        input_brep_file.as_posix(),
+        dist_tolerance,
+        logging=enable_logging,
+    )
+
+
+def check_brep_overlaps(
+    input_brep_file: StrPath,
+    *,
+    fuzzy_value: float = 0.001,
+    pave_time_limit: float | None = 10.0,
+    retry_fuzzy_values: list[float] | None = None,
+    retry_timeout_factor: float = 2.0,
+    concurrent_retries: bool = False,
+    cache_dir: StrPath | None = None,
+    enable_logging: bool = False,
+) -> list[OverlapPair]:
+    """Find the solids in a BREP file that touch or overlap each other.
+
+    Pairs of solids whose bounding boxes overlap are found first, then each
+    pair is classified concurrently with OpenCASCADE's boolean operations.
+    Overlapping solids are a common cause of lost particles.
+
+    Args:
+        input_brep_file: The path to the input BREP file.
+        fuzzy_value:
+            The distance within which solids are considered to touch.
+        pave_time_limit:
+            The maximum time in seconds to spend intersecting each pair,
+            `None` for no limit. Pairs that take longer are reported with
+            the `timeout` status.
+        retry_fuzzy_values:
+            Fuzzy values to retry pairs that fail or time out with, in order
+            of preference, e.g. `[fuzzy_value * 10, fuzzy_value / 10]`.
+        retry_timeout_factor:
+            How much longer each retry may take than the attempt before it.
+        concurrent_retries:
+            Try all of `retry_fuzzy_values` at once for a pair, keeping the
+            first in order that succeeds. Those after it are abandoned once
+            it does. Quicker when retries are common.
+        cache_dir:
+            A directory to keep the result of each pair in between runs, so
+            only pairs whose solids changed are intersected again. Created
+            if needed. Results of pairs not in this run are dropped from
+            it. `None` for no cache.
+        enable_logging: Whether to enable logging in the C++ extension code.
+
+    Returns:
+        The pairs of solids whose bounding boxes overlap, ordered by the
+        (zero based) indices `a` < `b` of the solids in `input_brep_file`.
+        Each has its `IntersectStatus`, the volume in common when they
+        overlap, the time spent on it, the number of attempts and fuzzy
+        value that gave the result, and whether it was `cached`. Other pairs
+        are distinct.
+    """
+    input_brep_file = Path(input_brep_file)
+
+    validate_file_extension(input_brep_file, ".brep")
+    validate_file_exists(input_brep_file)
+
+    fuzzy_value = none_guard(fuzzy_value, 0.001)
+    pave_time_limit = none_guard(pave_time_limit, 0.0)
+    if pave_time_limit < 0:
+        msg = f"Pave time limit should not be negative: {pave_time_limit}"
+        raise ValueError(msg)
+    retry_fuzzy_values = [float(v) for v in none_guard(retry_fuzzy_values, [])]
+    retry_timeout_factor = none_guard(retry_timeout_factor, 2.0)
+    if retry_timeout_factor <= 0:
+        msg = f"Retry timeout factor should be positive: {retry_timeout_factor}"
+        raise ValueError(msg)
+    concurrent_retries = none_guard(concurrent_retries, False)  # noqa: FBT003
+    cache_dir = "" if cache_dir is None else Path(cache_dir).as_posix()
+
+    return occ_overlap_checker(
+        input_brep_file.as_posix(),
+        fuzzy_value,
+        pave_time_limit_secs=pave_time_limit,
+        retry_fuzzy_values=retry_fuzzy_values,
+        retry_timeout_factor=retry_timeout_factor,
+        concurrent_retries=concurrent_retries,
+        cache_directory=cache_dir,
+        logging=enable_logging,
+    )
+
+
+def fix_brep_overlaps(
+    input_brep_file: StrPath,
+    output_brep_file: StrPath,
+    *,
+    fuzzy_value: float = 0.001,
+    pave_time_limit: float | None = 10.0,
+    cache_dir: StrPath | None = None,
+    enable_logging: bool = False,
+) -> list[OverlapFix]:
+    """Resolve the overlapping solids in a BREP file, ready for merging.
+
+    Overlapping pairs are found as by `check_brep_overlaps`, then the volume
+    each pair has in common is merged into the larger side. Pairs that share
+    no solid are resolved concurrently, in rounds.
+
+    Args:
+        input_brep_file: The path to the input BREP file.
+        output_brep_file: The path to the output BREP file.
+        fuzzy_value:
+            The distance within which solids are considered to touch.
+        pave_time_limit:
+            The maximum time in seconds to spend intersecting each pair,
+            when classifying it and again when imprinting it, `None` for no
+            limit. Pairs that take longer are left as they were.
+        cache_dir:
+            A directory to keep intersection and imprinting results in
+            between runs, as for `check_brep_overlaps`.
+        enable_logging: Whether to enable logging in the C++ extension code.
+
+    Returns:
+        How each overlapping pair was resolved, with the round it was
+        resolved in and whether its imprint was `cached`. Solids are in the
+        same order in both files.
+    """
+    input_brep_file = Path(input_brep_file)
+    output_brep_file = Path(output_brep_file)
+
+    validate_file_extension(input_brep_file, ".brep")
+    validate_file_exists(input_brep_file)
+    validate_file_extension(output_brep_file, ".brep")
+
+    fuzzy_value = none_guard(fuzzy_value, 0.001)
+    pave_time_limit = none_guard(pave_time_limit, 0.0)
+    if pave_time_limit < 0:
+        msg = f"Pave time limit should not be negative: {pave_time_limit}"
+        raise ValueError(msg)
+    cache_dir = "" if cache_dir is None else Path(cache_dir).as_posix()
+
+    return occ_overlap_fixer(
         input_brep_file.as_posix(),
         output_brep_file.as_posix(),
+        fuzzy_value,
+        pave_time_limit_secs=pave_time_limit,
+        cache_directory=cache_dir,
+        logging=enable_logging,
+    )
+
+
+def detect_brep_merges(
+    input_brep_file: StrPath,
+    *,
+    dist_tolerance: float = 0.001,
+    enable_logging: bool = False,
+) -> GlueDetection:
+    """Find what `merge_brep_geometries` would merge, without merging anything.
+
+    Only the detection phases of the merge are run, so this is a quick check
+    of a tolerance before committing to a full merge.
+
+    Args:
+        input_brep_file: The path to the input BREP file.
+        dist_tolerance:
+            The distance tolerance for merging entities
+            (vertices, edges, faces, etc.).
+        enable_logging: Whether to enable logging in the C++ extension code.
+
+    Returns:
+        The groups of coincident vertices, edges and faces. Each group has the
+        number of entities that would become one, and the (zero based, sorted)
+        indices of the solids in `input_brep_file` they belong to.
+    """
+    input_brep_file = Path(input_brep_file)
+
+    validate_file_extension(input_brep_file, ".brep")
+    validate_file_exists(input_brep_file)
+
+    dist_tolerance = none_guard(dist_tolerance, 0.001)
+
+    return occ_merger_detect(
+        input_brep_file.as_posix(),
         dist_tolerance,
-        enable_logging,
+        logging=enable_logging,
+    )
+
+
+def sweep_merge_tolerances(
+    input_brep_file: StrPath,
+    dist_tolerances: list[float],
+    *,
+    output_brep_file: StrPath | None = None,
+    output_dist_tolerance: float | None = None,
+    enable_logging: bool = False,
+) -> list[GlueStats]:
+    """Find what would be merged at each of several distance tolerances.
+
+    This is quicker than calling `merge_brep_geometries` for each tolerance,
+    the search for nearby vertices is done once at the largest tolerance and
+    only the entities merged at the largest tolerance are checked at the others.
+
+    Args:
+        input_brep_file: The path to the input BREP file.
+        dist_tolerances: The distance tolerances to try.
+        output_brep_file:
+            If given, the path to write the geometry merged at
+            `output_dist_tolerance` to.
+        output_dist_tolerance:
+            The tolerance, one of `dist_tolerances`, to merge the output at.
+            Defaults to the smallest tolerance.
+        enable_logging: Whether to enable logging in the C++ extension code.
+
+    Returns:
+        The counts of the work done (vertex clusters, glued edges and faces)
+        at each tolerance, in the order of `dist_tolerances`.
+    """
+    input_brep_file = Path(input_brep_file)
+
+    validate_file_extension(input_brep_file, ".brep")
+    validate_file_exists(input_brep_file)
+
+    if not dist_tolerances:
+        msg = "At least one tolerance is needed"
+        raise ValueError(msg)
+    if any(tol <= 0 for tol in dist_tolerances):
+        msg = f"Tolerances should be positive: {dist_tolerances}"
+        raise ValueError(msg)
+
+    if output_brep_file is None:
+        return occ_merger_sweep(
+            input_brep_file.as_posix(),
+            list(dist_tolerances),
+            logging=enable_logging,
+        )
+
+    output_brep_file = Path(output_brep_file)
+    validate_file_extension(output_brep_file, ".brep")
+
+    output_dist_tolerance = none_guard(output_dist_tolerance, min(dist_tolerances))
+    if output_dist_tolerance not in dist_tolerances:
+        msg = f"Output tolerance {output_dist_tolerance} is not one of {dist_tolerances}"
+        raise ValueError(msg)
+
+    return occ_merger_sweep(
+        input_brep_file.as_posix(),
+        list(dist_tolerances),
+        output_brep_file.as_posix(),
+        output_dist_tolerance,
+        logging=enable_logging,
+    )
+
+
+def merge_brep_geometries_incremental(
+    previous_merged_brep_file: StrPath,
+    replacement_brep_file: StrPath,
+    replaced_solids: list[int],
+    output_brep_file: StrPath,
+    *,
+    dist_tolerance: float = 0.001,
+    enable_logging: bool = False,
+) -> GlueStats:
+    """Merge replacement solids into a previously merged BREP file.
+
+    Only the replacement solids and the solids whose bounding boxes are near
+    them are glued, so small design changes do not require re-merging the
+    whole model. The faces and edges of all other solids are left unchanged.
+    A replacement vertex outside the tolerance of the existing vertex it
+    coincides with is left unmerged, along with the edges and faces on it, as
+    merging it would change the existing vertex. These are counted in the
+    returned `num_unglued` and logged as warnings.
+
+    Args:
+        previous_merged_brep_file:
+            The path to a BREP file produced by `merge_brep_geometries`.
+        replacement_brep_file:
+            The path to a BREP file containing the new geometry of the replaced
+            solids, in the same order as `replaced_solids`.
+        replaced_solids:
+            The (zero based) indices of the solids in
+            `previous_merged_brep_file` that are being replaced.
+        output_brep_file: The path to the output BREP file.
+        dist_tolerance:
+            The distance tolerance for merging entities
+            (vertices, edges, faces, etc.).
+        enable_logging: Whether to enable logging in the C++ extension code.
+
+    Returns:
+        The wall time of each phase of the merge and counts of the work done.
+    """
+    previous_merged_brep_file = Path(previous_merged_brep_file)
+    replacement_brep_file = Path(replacement_brep_file)
+    output_brep_file = Path(output_brep_file)
+
+    validate_file_extension(previous_merged_brep_file, ".brep")
+    validate_file_exists(previous_merged_brep_file)
+    validate_file_extension(replacement_brep_file, ".brep")
+    validate_file_exists(replacement_brep_file)
+    validate_file_extension(output_brep_file, ".brep")
+
+    dist_tolerance = none_guard(dist_tolerance, 0.001)
+
+    return occ_merger_incremental(
+        previous_merged_brep_file.as_posix(),
+        replacement_brep_file.as_posix(),
+        list(replaced_solids),
+        output_brep_file.as_posix(),
+        dist_tolerance,
+        logging=enable_logging,
     )
 
 
@@ -131,6 +583,8 @@ def facet_brep_to_dagmc(
     tol_is_absolute: bool = False,
     ang_deflection_tol: float = 0.5,
     scale_factor: float = 0.1,
+    mesh_merge_solids: list[int] | None = None,
+    mesh_merge_tolerance: float = 0.001,
     enable_logging: bool = False,
 ) -> None:
     """Facet .brep geometry and save it to a DAGMC MOAB .h5m file.
@@ -145,6 +599,18 @@ def facet_brep_to_dagmc(
             or relative to edge length.
         ang_deflection_tol: Angular deflection tolerance for faceting.
         scale_factor: Scale factor for the geometry. [may get removed]
+        mesh_merge_solids:
+            Indices of the top-level shapes in the BREP file that were not
+            merged, e.g. the `mesh_solids` returned by
+            `merge_brep_geometries`. The interfaces of their solids are made
+            conformal after faceting: nodes within `mesh_merge_tolerance` are
+            merged, and coincident faces of different solids become a single
+            surface, however each was discretized along its edges. A face
+            coinciding with only part of another face (e.g. one face against
+            several) is left non-conformal, and a warning is logged for it.
+        mesh_merge_tolerance:
+            The distance within which nodes of `mesh_merge_solids` are merged,
+            in the units of the BREP file.
         enable_logging: Whether to enable logging in the C++ extension code.
 
     Notes:
@@ -166,6 +632,8 @@ def facet_brep_to_dagmc(
     tol_is_absolute = none_guard(tol_is_absolute, False)  # noqa: FBT003
     ang_deflection_tol = none_guard(ang_deflection_tol, 0.5)
     scale_factor = none_guard(scale_factor, 0.1)
+    mesh_merge_solids = none_guard(mesh_merge_solids, [])
+    mesh_merge_tolerance = none_guard(mesh_merge_tolerance, 0.001)
 
     occ_faceter(
         input_brep_file.as_posix(),
@@ -175,6 +643,8 @@ def facet_brep_to_dagmc(
         tol_is_absolute,
         ang_deflection_tol,
         scale_factor,
+        mesh_merge_tolerance,
+        mesh_merge_solids,
         enable_logging,
     )
 
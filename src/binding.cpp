@@ -1,9 +1,12 @@
 #include <nanobind/nanobind.h>
+#include <nanobind/stl/array.h>
+#include <nanobind/stl/function.h>
 #include <nanobind/stl/string.h>
 #include <nanobind/stl/vector.h>
 
 #include "step_to_brep.hpp"
 #include "occ_merger.hpp"
+#include "overlap_checker.hpp"
 #include "occ_faceter.hpp"
 
 namespace nb = nanobind;
@@ -13,6 +16,107 @@ NB_MODULE(fast_ctd_ext, m)
       m.doc() = "Python bindings for OpenCASCADE shape merging and faceting, "
                 "for the creation of moab .h5m DAGMC models";
 
+      nb::exception<glue_cancelled>(m, "MergeCancelled", PyExc_RuntimeError);
+
+      nb::class_<glue_phase>(m, "GluePhase", "Wall time spent in one phase of the gluer")
+          .def_ro("name", &glue_phase::name)
+          .def_ro("seconds", &glue_phase::seconds)
+          .def_ro("memory_bytes", &glue_phase::memory_bytes);
+
+      nb::class_<glue_near_miss>(m, "GlueNearMiss", "A pair of vertices, edges or faces that were close but not merged")
+          .def_ro("type", &glue_near_miss::type)
+          .def_ro("tolerance", &glue_near_miss::tolerance)
+          .def_ro("solids_a", &glue_near_miss::solids_a)
+          .def_ro("solids_b", &glue_near_miss::solids_b)
+          .def_ro("position_a", &glue_near_miss::position_a)
+          .def_ro("position_b", &glue_near_miss::position_b);
+
+      nb::class_<glue_stats>(m, "GlueStats", "Timings and work counters from the gluer")
+          .def_ro("phases", &glue_stats::phases)
+          .def_ro("num_vertices", &glue_stats::num_vertices)
+          .def_ro("num_vertex_clusters", &glue_stats::num_vertex_clusters)
+          .def_ro("num_glued_vertices", &glue_stats::num_glued_vertices)
+          .def_ro("num_edge_buckets", &glue_stats::num_edge_buckets)
+          .def_ro("max_edge_bucket", &glue_stats::max_edge_bucket)
+          .def_ro("num_face_buckets", &glue_stats::num_face_buckets)
+          .def_ro("max_face_bucket", &glue_stats::max_face_bucket)
+          .def_ro("num_projections", &glue_stats::num_projections)
+          .def_ro("num_analytic_checks", &glue_stats::num_analytic_checks)
+          .def_ro("num_edge_groups", &glue_stats::num_edge_groups)
+          .def_ro("num_glued_edges", &glue_stats::num_glued_edges)
+          .def_ro("num_face_groups", &glue_stats::num_face_groups)
+          .def_ro("num_glued_faces", &glue_stats::num_glued_faces)
+          .def_ro("num_clusters", &glue_stats::num_clusters)
+          .def_ro("num_imprinted", &glue_stats::num_imprinted)
+          .def_ro("num_unglued", &glue_stats::num_unglued)
+          .def_ro("peak_memory_bytes", &glue_stats::peak_memory_bytes)
+          .def_ro("mesh_solids", &glue_stats::mesh_solids)
+          .def_ro("near_misses", &glue_stats::near_misses);
+
+      nb::class_<glue_group>(m, "GlueGroup", "Coincident vertices, edges or faces that would be merged into one")
+          .def_ro("size", &glue_group::size)
+          .def_ro("solids", &glue_group::solids);
+
+      nb::class_<glue_detection>(m, "GlueDetection", "Groups of coincident shapes found by a dry run of the merger")
+          .def_ro("vertices", &glue_detection::vertices)
+          .def_ro("edges", &glue_detection::edges)
+          .def_ro("faces", &glue_detection::faces);
+
+      nb::class_<merge_options>(m, "MergeOptions", "How occ_merger merges, see merge_brep_geometries")
+          .def(nb::init<>())
+          .def_rw("dist_tolerance", &merge_options::dist_tolerance)
+          .def_rw("engine", &merge_options::engine)
+          .def_rw("partitioned", &merge_options::partitioned)
+          .def_rw("groups", &merge_options::groups)
+          .def_rw("imprint", &merge_options::imprint)
+          .def_rw("mesh_solids", &merge_options::mesh_solids)
+          .def_rw("mesh_fallback", &merge_options::mesh_fallback)
+          .def_rw("cross_solid_only", &merge_options::cross_solid_only)
+          .def_rw("near_miss_tolerance", &merge_options::near_miss_tolerance)
+          .def_rw("time_limit_secs", &merge_options::time_limit_secs);
+
+      nb::class_<merge_benchmark>(m, "MergeBenchmark", "One engine's merge of a BREP file when benchmarking")
+          .def_ro("engine", &merge_benchmark::engine)
+          .def_ro("seconds", &merge_benchmark::seconds)
+          .def_ro("memory_bytes", &merge_benchmark::memory_bytes)
+          .def_ro("passed", &merge_benchmark::passed)
+          .def_ro("stats", &merge_benchmark::stats);
+
+      nb::enum_<intersect_status>(m, "IntersectStatus", "How a pair of solids intersect, subject to the fuzzy value")
+          .value("failed", intersect_status::failed)
+          .value("timeout", intersect_status::timeout)
+          .value("distinct", intersect_status::distinct)
+          .value("touching", intersect_status::touching)
+          .value("overlap", intersect_status::overlap);
+
+      nb::class_<overlap_pair>(m, "OverlapPair", "Classification of a pair of solids that could touch or overlap")
+          .def_ro("a", &overlap_pair::a)
+          .def_ro("b", &overlap_pair::b)
+          .def_ro("status", &overlap_pair::status)
+          .def_ro("fuzzy_value", &overlap_pair::fuzzy_value)
+          .def_ro("attempts", &overlap_pair::attempts)
+          .def_ro("cached", &overlap_pair::cached)
+          .def_ro("vol_common", &overlap_pair::vol_common)
+          .def_ro("vol_cut", &overlap_pair::vol_cut)
+          .def_ro("vol_cut12", &overlap_pair::vol_cut12)
+          .def_ro("pave_seconds", &overlap_pair::pave_seconds)
+          .def_ro("seconds", &overlap_pair::seconds);
+
+      nb::enum_<imprint_status>(m, "ImprintStatus", "How the common volume of a pair of solids was resolved")
+          .value("failed", imprint_status::failed)
+          .value("distinct", imprint_status::distinct)
+          .value("merge_into_shape", imprint_status::merge_into_shape)
+          .value("merge_into_tool", imprint_status::merge_into_tool);
+
+      nb::class_<overlap_fix>(m, "OverlapFix", "How a pair of overlapping solids was resolved")
+          .def_ro("a", &overlap_fix::a)
+          .def_ro("b", &overlap_fix::b)
+          .def_ro("status", &overlap_fix::status)
+          .def_ro("fuzzy_value", &overlap_fix::fuzzy_value)
+          .def_ro("vol_common", &overlap_fix::vol_common)
+          .def_ro("round", &overlap_fix::round)
+          .def_ro("cached", &overlap_fix::cached);
+
       m.def("occ_step_to_brep", &occ_step_to_brep,
             "Convert a STEP file to a BREP file",
             nb::arg("input_step_file"),
@@ -22,13 +126,74 @@ NB_MODULE(fast_ctd_ext, m)
             nb::arg("fix_geometry"),
             nb::arg("logging") = false);
 
+      m.def("check_merge_options", &check_merge_options,
+            "Why the merge options can't be combined, or an empty string when they can",
+            nb::arg("options"));
+
       m.def("occ_merger", &occ_merger,
             "Merge shapes from an input BREP file and write the result to an output BREP file",
             nb::arg("input_brep_file"),
             nb::arg("output_brep_file"),
+            nb::arg("options"),
+            nb::arg("progress_callback").none() = nb::none(),
+            nb::arg("logging") = false,
+            // the progress callback can be called from worker threads
+            nb::call_guard<nb::gil_scoped_release>());
+
+      m.def("occ_merger_incremental", &occ_merger_incremental,
+            "Merge replacement solids into a previously merged BREP file and write the result to an output BREP file",
+            nb::arg("previous_brep_file"),
+            nb::arg("replacement_brep_file"),
+            nb::arg("replaced_solids"),
+            nb::arg("output_brep_file"),
             nb::arg("dist_tolerance"),
             nb::arg("logging") = false);
 
+      m.def("occ_merger_detect", &occ_merger_detect,
+            "Find the shapes in a BREP file that would be merged, without merging them",
+            nb::arg("input_brep_file"),
+            nb::arg("dist_tolerance"),
+            nb::arg("logging") = false);
+
+      m.def("occ_merger_sweep", &occ_merger_sweep,
+            "Report what would be merged at several tolerances, optionally merging at one of them",
+            nb::arg("input_brep_file"),
+            nb::arg("dist_tolerances"),
+            nb::arg("output_brep_file") = "",
+            nb::arg("output_dist_tolerance") = 0.0,
+            nb::arg("logging") = false);
+
+      m.def("occ_merger_benchmark", &occ_merger_benchmark,
+            "Merge a BREP file with each merge engine, reporting their time, memory use and glued counts",
+            nb::arg("input_brep_file"),
+            nb::arg("dist_tolerance"),
+            nb::arg("logging") = false,
+            // OCCT's parallel fuse runs on its own threads
+            nb::call_guard<nb::gil_scoped_release>());
+
+      m.def("occ_overlap_checker", &occ_overlap_checker,
+            "Classify the pairs of solids in a BREP file that could touch or overlap",
+            nb::arg("input_brep_file"),
+            nb::arg("fuzzy_value"),
+            nb::arg("pave_time_limit_secs") = 0.0,
+            nb::arg("retry_fuzzy_values") = std::vector<double>{},
+            nb::arg("retry_timeout_factor") = 2.0,
+            nb::arg("concurrent_retries") = false,
+            nb::arg("cache_directory") = "",
+            nb::arg("logging") = false,
+            // pairs are classified on OCCT's worker threads
+            nb::call_guard<nb::gil_scoped_release>());
+
+      m.def("occ_overlap_fixer", &occ_overlap_fixer,
+            "Resolve the overlapping solids in a BREP file, writing an overlap-free BREP file",
+            nb::arg("input_brep_file"),
+            nb::arg("output_brep_file"),
+            nb::arg("fuzzy_value"),
+            nb::arg("pave_time_limit_secs") = 0.0,
+            nb::arg("cache_directory") = "",
+            nb::arg("logging") = false,
+            nb::call_guard<nb::gil_scoped_release>());
+
       m.def("occ_faceter", &occ_faceter,
             "Facet a geometry and save it to a MOAB h5m file",
             nb::arg("input_brep_file"),
@@ -38,5 +203,7 @@ NB_MODULE(fast_ctd_ext, m)
             nb::arg("tol_is_absolute"),
             nb::arg("ang_deflection_tol"),
             nb::arg("scale_factor"),
+            nb::arg("mesh_merge_tolerance") = 0.0,
+            nb::arg("mesh_merge_solids") = std::vector<size_t>{},
             nb::arg("logging") = false);
 }
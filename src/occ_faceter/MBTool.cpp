@@ -1,6 +1,7 @@
 #include "MBTool.hpp"
 
 #include <iostream>
+#include <cmath>
 #include <cstring>
 
 #include <spdlog/spdlog.h>
@@ -57,6 +58,7 @@ raise_moab_error(moab::ErrorCode rval, const char *file, const int line, const c
 MBTool::MBTool()
 {
   scale_factor = 1;
+  snap_tolerance = 0;
   mbi = nullptr;
   geom_tool = nullptr;
 
@@ -122,6 +124,12 @@ void MBTool::set_scale_factor(double x)
   scale_factor = x;
 }
 
+// distance (before scaling) within which find_or_snap_node reuses a node
+void MBTool::set_snap_tolerance(double snap_tol)
+{
+  snap_tolerance = snap_tol;
+}
+
 void MBTool::set_faceting_tol_tag(double faceting_tol)
 {
   moab::EntityHandle set = rootset; // ? *rootset : 0;
@@ -265,6 +273,92 @@ moab::EntityHandle MBTool::find_or_create_node(std::array<double, 3> coord)
   return result;
 }
 
+// as find_or_create_node, but reuse the nearest node made by this method within
+// the snap tolerance, so nearly coincident nodes of unglued faces are merged
+moab::EntityHandle MBTool::find_or_snap_node(std::array<double, 3> coord)
+{
+  const double tol = snap_tolerance * scale_factor;
+  if (tol <= 0)
+  {
+    return find_or_create_node(coord);
+  }
+
+  if (scale_factor != 1)
+  {
+    coord[0] *= scale_factor;
+    coord[1] *= scale_factor;
+    coord[2] *= scale_factor;
+  }
+
+  auto it = verticies.find(coord);
+  if (it != verticies.end())
+  {
+    return it->second;
+  }
+
+  // cells are as wide as the tolerance, so any node within it is in this
+  // cell or a neighbouring one
+  grid_cell cell;
+  for (int i = 0; i < 3; i++)
+  {
+    cell.index[i] = (long long)std::floor(coord[i] / tol);
+  }
+
+  moab::EntityHandle result = 0;
+  double best = tol * tol;
+  for (long long dx = -1; dx <= 1; dx++)
+    for (long long dy = -1; dy <= 1; dy++)
+      for (long long dz = -1; dz <= 1; dz++)
+      {
+        auto found = snap_grid.find({{cell.index[0] + dx, cell.index[1] + dy, cell.index[2] + dz}});
+        if (found == snap_grid.end())
+          continue;
+
+        for (const auto &[point, node] : found->second)
+        {
+          double dist = 0;
+          for (int i = 0; i < 3; i++)
+          {
+            dist += (point[i] - coord[i]) * (point[i] - coord[i]);
+          }
+          if (dist <= best)
+          {
+            best = dist;
+            result = node;
+          }
+        }
+      }
+
+  if (result == 0)
+  {
+    CHECK_MOAB_RVAL(mbi->create_vertex(coord.data(), result));
+    snap_grid[cell].emplace_back(coord, result);
+  }
+  // later lookups of exactly these coordinates get the same node
+  verticies.emplace(std::make_pair(coord, result));
+  return result;
+}
+
+// a new node at the average of the nodes' (already scaled) coordinates
+moab::EntityHandle MBTool::create_node_at_centroid(const entity_vector &nodes)
+{
+  std::vector<double> coords(3 * nodes.size());
+  CHECK_MOAB_RVAL(mbi->get_coords(nodes.data(), (int)nodes.size(), coords.data()));
+
+  std::array<double, 3> centroid = {0, 0, 0};
+  for (size_t i = 0; i < nodes.size(); i++)
+  {
+    for (int j = 0; j < 3; j++)
+    {
+      centroid[j] += coords[3 * i + j] / nodes.size();
+    }
+  }
+
+  moab::EntityHandle result;
+  CHECK_MOAB_RVAL(mbi->create_vertex(centroid.data(), result));
+  return result;
+}
+
 moab::EntityHandle MBTool::create_triangle(std::array<moab::EntityHandle, 3> verticies)
 {
   moab::EntityHandle result;
@@ -26,6 +26,7 @@ public:
   void set_scale_factor(double scale_factor);
   void set_faceting_tol_tag(double faceting_tol);
   void set_geometry_tol_tag(double geom_tol);
+  void set_snap_tolerance(double snap_tol);
   moab::EntityHandle make_new_volume();
   moab::EntityHandle make_new_surface();
   moab::EntityHandle make_new_curve();
@@ -34,6 +35,8 @@ public:
   void write_geometry(const std::string &filename);
 
   moab::EntityHandle find_or_create_node(std::array<double, 3> point);
+  moab::EntityHandle find_or_snap_node(std::array<double, 3> point);
+  moab::EntityHandle create_node_at_centroid(const entity_vector &nodes);
   moab::EntityHandle create_triangle(std::array<moab::EntityHandle, 3> verticies);
   moab::EntityHandle create_edge(std::array<moab::EntityHandle, 2> verticies);
   void add_entities(moab::EntityHandle meshset, const entity_vector &entities);
@@ -57,6 +60,8 @@ private:
 
   moab::Core *mbi;
   coordinates_to_entity_map verticies;
+  grid_to_entities_map snap_grid; // nodes made by find_or_snap_node
+  double snap_tolerance;
 
   moab::GeomTopoTool *geom_tool;
   int entity_id[5]; // group, volume, surface, curve IDs (indexed by dim)
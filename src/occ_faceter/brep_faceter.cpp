@@ -3,7 +3,9 @@
 #include <iostream>
 #include <algorithm>
 #include <array>
+#include <cmath>
 #include <map>
+#include <set>
 #include <unordered_map>
 #include <omp.h>
 
@@ -24,16 +26,23 @@
 #include "TopoDS_Edge.hxx"
 
 #include "TopTools_HSequenceOfShape.hxx"
+#include "TopoDS_Iterator.hxx"
 #include "TopExp_Explorer.hxx"
 #include "TopExp.hxx"
 
 #include "TopLoc_Location.hxx"
+#include "gp_XYZ.hxx"
 
 #include "BRepOffsetAPI_Sewing.hxx"
+#include "BRepBuilderAPI_MakeVertex.hxx"
+#include "BRepExtrema_DistShapeShape.hxx"
 
 #include "BRepTools.hxx"
 #include "BRep_Builder.hxx"
+#include "NCollection_DataMap.hxx"
 #include "NCollection_IndexedDataMap.hxx"
+#include "TopTools_IndexedMapOfShape.hxx"
+#include "TopTools_MapOfShape.hxx"
 
 #include <spdlog/spdlog.h>
 
@@ -58,13 +67,256 @@
 typedef NCollection_IndexedDataMap<TopoDS_Face, moab::EntityHandle, TopTools_ShapeMapHasher> MapFaceToSurface;
 typedef NCollection_IndexedDataMap<TopoDS_Edge, moab::EntityHandle, TopTools_ShapeMapHasher> MapEdgeToCurve;
 typedef NCollection_IndexedDataMap<TopoDS_Vertex, moab::EntityHandle, TopTools_ShapeMapHasher> MapVertexToMeshset;
+typedef NCollection_DataMap<TopoDS_Shape, TopoDS_Shape, TopTools_ShapeMapHasher> MapShapeToShape;
+
+namespace
+{
+  // nodes along an edge of a face, in the edge's direction, and the points
+  // they were made from
+  struct EdgeNodes
+  {
+    TopoDS_Edge edge;
+    entity_vector ordered;
+    std::vector<gp_XYZ> points;
+  };
+
+  // what the triangulation of a face says about it, for telling whether two
+  // faces with the same boundary vertices cover the same region
+  struct FaceMeshInfo
+  {
+    TopoDS_Face face;
+    size_t solid;
+    // sum of the triangle normals, in the orientation of the face's surface
+    gp_XYZ normal;
+    gp_XYZ centroid;
+    double area;
+    std::vector<EdgeNodes> edges;
+  };
+
+  // the edge of another face an edge follows
+  struct EdgeMatch
+  {
+    size_t edge;
+    bool same_direction;
+  };
+
+  FaceMeshInfo describe_face(const TopoDS_Face &face, size_t solid,
+                             const Handle(Poly_Triangulation) & triangulation,
+                             const TopLoc_Location &location,
+                             const entity_vector &nodes)
+  {
+    FaceMeshInfo info{face, solid, gp_XYZ(), gp_XYZ(), 0, {}};
+
+    const gp_Trsf &local_transform = location;
+    for (int i = 1; i <= triangulation->NbTriangles(); i++)
+    {
+      int a, b, c;
+      triangulation->Triangle(i).Get(a, b, c);
+      const gp_XYZ pa = triangulation->Node(a).Transformed(local_transform).XYZ();
+      const gp_XYZ pb = triangulation->Node(b).Transformed(local_transform).XYZ();
+      const gp_XYZ pc = triangulation->Node(c).Transformed(local_transform).XYZ();
+
+      const gp_XYZ normal = (pb - pa).Crossed(pc - pa);
+      const double area = normal.Modulus() / 2;
+      info.normal += normal;
+      info.centroid += (pa + pb + pc) * (area / 3);
+      info.area += area;
+    }
+    if (info.area > 0)
+    {
+      info.centroid /= info.area;
+    }
+
+    for (TopExp_Explorer ex(face, TopAbs_EDGE); ex.More(); ex.Next())
+    {
+      const TopoDS_Edge &edge = TopoDS::Edge(ex.Current());
+      if (BRep_Tool::Degenerated(edge))
+        continue;
+
+      Handle(Poly_PolygonOnTriangulation) polygon =
+          BRep_Tool::PolygonOnTriangulation(edge, triangulation, location);
+      if (polygon.IsNull() || polygon->NbNodes() < 2)
+        continue;
+
+      EdgeNodes edge_nodes{edge, {}, {}};
+      for (int line : polygon->Nodes())
+      {
+        edge_nodes.ordered.push_back(nodes.at(line - 1));
+        edge_nodes.points.push_back(triangulation->Node(line).Transformed(local_transform).XYZ());
+      }
+      info.edges.push_back(std::move(edge_nodes));
+    }
+    return info;
+  }
+
+  // faces with the same boundary vertices can still differ inside, e.g. a
+  // disc and a dome on the same circle. their triangulations are only
+  // accurate to the faceting tolerance, so compare them loosely
+  bool same_region(const FaceMeshInfo &lhs, const FaceMeshInfo &rhs, double tolerance)
+  {
+    const double area = std::max(lhs.area, rhs.area);
+    return std::abs(lhs.area - rhs.area) <= 0.01 * area &&
+           (lhs.centroid - rhs.centroid).Modulus() <= tolerance + 0.01 * std::sqrt(area);
+  }
+
+  // how far along a polyline each of its points is, as a fraction of its
+  // length
+  std::vector<double> fractions_along(const std::vector<gp_XYZ> &points)
+  {
+    std::vector<double> fractions(points.size(), 0);
+    for (size_t i = 1; i < points.size(); i++)
+    {
+      fractions[i] = fractions[i - 1] + (points[i] - points[i - 1]).Modulus();
+    }
+    const double length = fractions.empty() ? 0 : fractions.back();
+    if (length > 0)
+    {
+      for (double &fraction : fractions)
+      {
+        fraction /= length;
+      }
+    }
+    return fractions;
+  }
+
+  gp_XYZ point_along(const std::vector<gp_XYZ> &points, const std::vector<double> &fractions,
+                     double fraction)
+  {
+    const auto upper = std::lower_bound(fractions.begin(), fractions.end(), fraction);
+    if (upper == fractions.begin())
+      return points.front();
+    if (upper == fractions.end())
+      return points.back();
+
+    const size_t i = (size_t)(upper - fractions.begin());
+    const double span = fractions[i] - fractions[i - 1];
+    const double t = span > 0 ? (fraction - fractions[i - 1]) / span : 0;
+    return points[i - 1] + (points[i] - points[i - 1]) * t;
+  }
+
+  double length_of(const std::vector<gp_XYZ> &points)
+  {
+    double length = 0;
+    for (size_t i = 1; i < points.size(); i++)
+    {
+      length += (points[i] - points[i - 1]).Modulus();
+    }
+    return length;
+  }
+
+  // whether the polylines of two edges follow the same curve between the
+  // same (snapped) vertices, either way round, however each was discretized.
+  // points a quarter, half and three quarters of the way along are compared,
+  // which also tells the direction of closed edges
+  bool same_curve(const EdgeNodes &lhs, const EdgeNodes &rhs, double tolerance, bool &same_direction)
+  {
+    const std::vector<double> lhs_fractions = fractions_along(lhs.points);
+    const std::vector<double> rhs_fractions = fractions_along(rhs.points);
+    const double slack = tolerance + 0.01 * std::max(length_of(lhs.points), length_of(rhs.points));
+
+    const auto follows = [&](bool reversed)
+    {
+      const moab::EntityHandle first = reversed ? rhs.ordered.back() : rhs.ordered.front();
+      const moab::EntityHandle last = reversed ? rhs.ordered.front() : rhs.ordered.back();
+      if (lhs.ordered.front() != first || lhs.ordered.back() != last)
+        return false;
+
+      for (double fraction : {0.25, 0.5, 0.75})
+      {
+        const gp_XYZ point = point_along(lhs.points, lhs_fractions, fraction);
+        const gp_XYZ other = point_along(rhs.points, rhs_fractions, reversed ? 1 - fraction : fraction);
+        if ((point - other).Modulus() > slack)
+          return false;
+      }
+      return true;
+    };
+
+    if (follows(false))
+    {
+      same_direction = true;
+      return true;
+    }
+    if (follows(true))
+    {
+      same_direction = false;
+      return true;
+    }
+    return false;
+  }
+
+  // the edge of `kept` each edge of `replaced` follows, when every edge of
+  // each follows an edge of the other
+  bool match_edges(const FaceMeshInfo &replaced, const FaceMeshInfo &kept, double tolerance,
+                   std::vector<EdgeMatch> &matches)
+  {
+    matches.clear();
+    std::vector<bool> followed(kept.edges.size(), false);
+    for (const EdgeNodes &edge : replaced.edges)
+    {
+      EdgeMatch match{kept.edges.size(), false};
+      for (size_t i = 0; i < kept.edges.size(); i++)
+      {
+        if (same_curve(edge, kept.edges[i], tolerance, match.same_direction))
+        {
+          match.edge = i;
+          break;
+        }
+      }
+      if (match.edge == kept.edges.size())
+        return false;
+
+      followed[match.edge] = true;
+      matches.push_back(match);
+    }
+    return std::all_of(followed.begin(), followed.end(), [](bool f)
+                       { return f; });
+  }
+
+  // whether some of a face's triangles lie on another face, as far as they
+  // are from their own face give or take the tolerance. triangles spread
+  // over the face are sampled, rather than checking them all
+  bool lies_partly_on(const TopoDS_Face &face, const TopoDS_Face &other, double tolerance)
+  {
+    TopLoc_Location location;
+    Handle(Poly_Triangulation) triangulation = BRep_Tool::Triangulation(face, location);
+    if (triangulation.IsNull() || triangulation->NbTriangles() < 1)
+      return false;
+
+    const gp_Trsf &local_transform = location;
+    const int step = std::max(1, triangulation->NbTriangles() / 8);
+    for (int i = 1; i <= triangulation->NbTriangles(); i += step)
+    {
+      int a, b, c;
+      triangulation->Triangle(i).Get(a, b, c);
+      const gp_XYZ centroid = (triangulation->Node(a).XYZ() +
+                               triangulation->Node(b).XYZ() +
+                               triangulation->Node(c).XYZ()) /
+                              3;
+      const TopoDS_Vertex vertex = BRepBuilderAPI_MakeVertex(gp_Pnt(centroid).Transformed(local_transform));
+
+      // nearest to the other face's boundary means beside it, not on it
+      BRepExtrema_DistShapeShape to_other(vertex, other);
+      if (!to_other.IsDone() || to_other.NbSolution() < 1 ||
+          to_other.SupportTypeShape2(1) != BRepExtrema_IsInFace)
+        continue;
+
+      BRepExtrema_DistShapeShape to_own(vertex, face);
+      const double deviation = to_own.IsDone() ? to_own.Value() : 0;
+      if (to_other.Value() <= tolerance + deviation)
+        return true;
+    }
+    return false;
+  }
+}
 
 class BrepFaceter
 {
 public:
-  BrepFaceter(MBTool &mbt) : mbtool(mbt),
-                             degenerate_triangle_count(0),
-                             surface_without_facet_count(0) {}
+  BrepFaceter(MBTool &mbt, const MeshMergeOptions &mesh_merge = MeshMergeOptions())
+      : mbtool(mbt),
+        meshMerge(mesh_merge),
+        degenerate_triangle_count(0),
+        surface_without_facet_count(0) {}
 
   entity_vector facet(const TopTools_HSequenceOfShape &shape_list,
                       const FacetingTolerance &facet_tol);
@@ -76,68 +328,145 @@ private:
   MapVertexToMeshset vertexMap;
   entity_vector volumesList;
 
+  // mesh space merging: faces whose nodes are snapped, and faces (edges,
+  // vertices) replaced by a coincident one of another solid. replacements
+  // running the other way to the shape they replace are in reversedAliases
+  MeshMergeOptions meshMerge;
+  TopTools_MapOfShape snappedFaces;
+  MapShapeToShape aliases;
+  TopTools_MapOfShape reversedAliases;
+  // nodes of each curve that edges discretized differently were aliased to,
+  // along it, and the nodes to insert into segments of the faces' boundaries
+  // (keyed by their nodes, lowest first, listed in that direction) so they
+  // all meet the curve at every one of its nodes
+  NCollection_DataMap<TopoDS_Shape, entity_vector, TopTools_ShapeMapHasher> stitchedCurves;
+  std::map<std::pair<moab::EntityHandle, moab::EntityHandle>, entity_vector> segmentInsertions;
+
   int degenerate_triangle_count;
   int surface_without_facet_count;
 
   void create_surfaces(const TopTools_HSequenceOfShape &shape_list);
+  void create_surface_meshsets();
   void perform_faceting(const FacetingTolerance &facet_tol);
+  void merge_coincident_faces(const TopTools_HSequenceOfShape &shape_list);
+  void alias_face(const FaceMeshInfo &replaced, const FaceMeshInfo &kept,
+                  const std::vector<EdgeMatch> &matches);
+  void stitch_curves(const std::vector<FaceMeshInfo> &faces);
+  int warn_partly_coincident(const std::vector<FaceMeshInfo> &faces,
+                             const std::vector<bool> &matched) const;
   void populate_all_surfaces();
   void create_volumes_and_add_children(const TopTools_HSequenceOfShape &shape_list);
 
-  void create_surface_nodes(entity_vector &nodes, const Poly_Triangulation &triangulation, const TopLoc_Location &location);
+  void create_surface_nodes(entity_vector &nodes, const Poly_Triangulation &triangulation, const TopLoc_Location &location, bool snap = false);
+  void create_boundary_nodes(entity_vector &nodes, const TopoDS_Face &face, const Handle(Poly_Triangulation) & triangulation, const TopLoc_Location &location);
   void create_surface_triangles(entity_vector &triangles, moab::EntityHandle surface, const Poly_Triangulation &triangulation, const entity_vector &nodes);
 
-  void populate_vertex(moab::EntityHandle meshset, const TopoDS_Vertex &currentVertex)
+  // the shape meshed in place of shape, following replacements of the
+  // shapes it was replaced by
+  const TopoDS_Shape &resolve(const TopoDS_Shape &shape) const
+  {
+    const TopoDS_Shape *current = &shape;
+    while (const TopoDS_Shape *alias = aliases.Seek(*current))
+    {
+      current = alias;
+    }
+    return *current;
+  }
+
+  // whether the shape meshed in place of shape runs the other way to it
+  bool reversed_alias(const TopoDS_Shape &shape) const
+  {
+    bool reversed = false;
+    const TopoDS_Shape *current = &shape;
+    while (const TopoDS_Shape *alias = aliases.Seek(*current))
+    {
+      reversed = reversed != reversedAliases.Contains(*current);
+      current = alias;
+    }
+    return reversed;
+  }
+
+  // the nodes of stitched curves inside a segment of a face's boundary, in
+  // order from `from` to `to`
+  entity_vector segment_insertions(moab::EntityHandle from, moab::EntityHandle to) const
+  {
+    auto found = segmentInsertions.find({std::min(from, to), std::max(from, to)});
+    if (found == segmentInsertions.end())
+      return {};
+
+    entity_vector nodes = found->second;
+    if (from > to)
+    {
+      std::reverse(nodes.begin(), nodes.end());
+    }
+    return nodes;
+  }
+
+  moab::EntityHandle vertex_node(const TopoDS_Vertex &vertex)
   {
-    // create and add contents
     double x, y, z;
-    BRep_Tool::Pnt(currentVertex).Coord().Coord(x, y, z);
-    moab::EntityHandle node = mbtool.find_or_create_node({x, y, z});
+    BRep_Tool::Pnt(vertex).Coord().Coord(x, y, z);
+    return meshMerge.enabled() ? mbtool.find_or_snap_node({x, y, z})
+                               : mbtool.find_or_create_node({x, y, z});
+  }
 
-    mbtool.add_entity(meshset, node);
+  void populate_vertex(moab::EntityHandle meshset, const TopoDS_Vertex &currentVertex)
+  {
+    // create and add contents
+    mbtool.add_entity(meshset, vertex_node(currentVertex));
   }
 
   void populate_curve(moab::EntityHandle curve,
                       const TopoDS_Edge &currentEdge,
                       const Handle(Poly_Triangulation) & triangulation,
                       const TopLoc_Location &location,
-                      const entity_vector &surfaceNodes)
+                      const entity_vector &surfaceNodes,
+                      bool reversed = false)
   {
-    // get the faceting for the edge
-    Handle(Poly_PolygonOnTriangulation) edges =
-        BRep_Tool::PolygonOnTriangulation(currentEdge, triangulation, location);
+    entity_vector mbedge_entities;
+    entity_vector node_entities;
 
-    if (edges.IsNull())
+    // a stitched curve has the nodes of every edge it stands for
+    if (const entity_vector *stitched = stitchedCurves.Seek(resolve(currentEdge)))
     {
-      spdlog::warn("Unexpected null edges.");
-      return;
+      node_entities = *stitched;
     }
-
-    const TColStd_Array1OfInteger &lines = edges->Nodes();
-    if (lines.Length() < 2)
+    else
     {
-      spdlog::warn("Attempting to build empty curve.");
-      return;
-    }
+      // get the faceting for the edge
+      Handle(Poly_PolygonOnTriangulation) edges =
+          BRep_Tool::PolygonOnTriangulation(currentEdge, triangulation, location);
 
-    entity_vector mbedge_entities;
-    entity_vector node_entities;
+      if (edges.IsNull())
+      {
+        spdlog::warn("Unexpected null edges.");
+        return;
+      }
 
-    auto occ_edge_it = lines.cbegin();
+      const TColStd_Array1OfInteger &lines = edges->Nodes();
+      if (lines.Length() < 2)
+      {
+        spdlog::warn("Attempting to build empty curve.");
+        return;
+      }
 
-    // subtract one because OCC uses one based indexing
-    moab::EntityHandle prev = surfaceNodes.at(*occ_edge_it - 1);
-    node_entities.push_back(prev);
-    occ_edge_it++;
+      // subtract one because OCC uses one based indexing
+      for (int line : lines)
+      {
+        node_entities.push_back(surfaceNodes.at(line - 1));
+      }
 
-    for (; occ_edge_it != lines.cend(); occ_edge_it++)
-    {
-      moab::EntityHandle node = surfaceNodes.at(*occ_edge_it - 1);
-      moab::EntityHandle edge = mbtool.create_edge({prev, node});
+      // a curve populated through a reversed alias still follows the
+      // direction of the edge it stands for
+      if (reversed)
+      {
+        std::reverse(node_entities.begin(), node_entities.end());
+      }
+    }
 
-      node_entities.push_back(node);
-      mbedge_entities.push_back(edge);
-      prev = node;
+    for (size_t i = 1; i < node_entities.size(); i++)
+    {
+      mbedge_entities.push_back(mbtool.create_edge({node_entities[i - 1], node_entities[i]}));
     }
 
     // if curve is closed, remove duplicate vertex
@@ -153,7 +482,7 @@ private:
     // create and populate children
     for (TopExp_Explorer explorer(currentEdge, TopAbs_VERTEX); explorer.More(); explorer.Next())
     {
-      const TopoDS_Vertex &currentVertex = TopoDS::Vertex(explorer.Current());
+      const TopoDS_Vertex &currentVertex = TopoDS::Vertex(resolve(explorer.Current()));
 
       moab::EntityHandle meshset;
       if (!vertexMap.FindFromKey(currentVertex, meshset))
@@ -182,7 +511,7 @@ private:
 
     // add contents to surface
     entity_vector nodes;
-    create_surface_nodes(nodes, triangulation, location);
+    create_surface_nodes(nodes, triangulation, location, snappedFaces.Contains(face));
     mbtool.add_entities(surface, nodes);
 
     entity_vector triangles;
@@ -193,14 +522,16 @@ private:
     for (TopExp_Explorer edges(face, TopAbs_EDGE); edges.More(); edges.Next())
     {
       const TopoDS_Edge &currentEdge = TopoDS::Edge(edges.Current());
+      const TopoDS_Edge &curveEdge = TopoDS::Edge(resolve(currentEdge));
+      const bool reversed = reversed_alias(currentEdge);
       moab::EntityHandle curve;
-      if (!edgeMap.FindFromKey(currentEdge, curve))
+      if (!edgeMap.FindFromKey(curveEdge, curve))
       {
         curve = mbtool.make_new_curve();
-        edgeMap.Add(currentEdge, curve);
-        populate_curve(curve, currentEdge, triangulation, location, nodes);
+        edgeMap.Add(curveEdge, curve);
+        populate_curve(curve, currentEdge, triangulation, location, nodes, reversed);
       }
-      int sense = currentEdge.Orientation() != face.Orientation() ? moab::SENSE_REVERSE : moab::SENSE_FORWARD;
+      int sense = (currentEdge.Orientation() != face.Orientation()) != reversed ? moab::SENSE_REVERSE : moab::SENSE_FORWARD;
       mbtool.add_child_to_parent(curve, surface, sense);
     }
   }
@@ -210,8 +541,9 @@ private:
     for (TopExp_Explorer ex(shape, TopAbs_FACE); ex.More(); ex.Next())
     {
       const TopoDS_Face &face = TopoDS::Face(ex.Current());
-      moab::EntityHandle surface = surfaceMap.FindFromKey(face);
-      int sense = face.Orientation() == TopAbs_REVERSED ? moab::SENSE_REVERSE : moab::SENSE_FORWARD;
+      moab::EntityHandle surface = surfaceMap.FindFromKey(resolve(face));
+      const bool reversed = reversed_alias(face);
+      int sense = (face.Orientation() == TopAbs_REVERSED) != reversed ? moab::SENSE_REVERSE : moab::SENSE_FORWARD;
       mbtool.add_child_to_parent(surface, vol, sense);
     }
   }
@@ -219,7 +551,8 @@ private:
 
 void BrepFaceter::create_surfaces(const TopTools_HSequenceOfShape &shape_list)
 {
-  // list unique faces, create empty surfaces, and build surface map
+  // list unique faces and build surface map, the surfaces themselves are
+  // created once it is known which faces are merged in mesh space
 
   // Important note: For the maps, edge/face equivalence is defined
   // by TopoDS_Shape::IsSame(), which ignores the orientation.
@@ -231,14 +564,26 @@ void BrepFaceter::create_surfaces(const TopTools_HSequenceOfShape &shape_list)
       if (surfaceMap.Contains(face))
         continue;
 
-      surfaceMap.Add(face, mbtool.make_new_surface());
+      surfaceMap.Add(face, 0);
+    }
+  }
+}
+
+void BrepFaceter::create_surface_meshsets()
+{
+  for (int i = 1; i <= surfaceMap.Extent(); i++)
+  {
+    if (!aliases.IsBound(surfaceMap.FindKey(i)))
+    {
+      surfaceMap.ChangeFromIndex(i) = mbtool.make_new_surface();
     }
   }
 }
 
 void BrepFaceter::create_surface_nodes(entity_vector &nodes,
                                        const Poly_Triangulation &triangulation,
-                                       const TopLoc_Location &location)
+                                       const TopLoc_Location &location,
+                                       bool snap)
 {
   const gp_Trsf &local_transform = location;
   // retrieve facet data
@@ -247,7 +592,39 @@ void BrepFaceter::create_surface_nodes(entity_vector &nodes,
     Standard_Real x, y, z;
     triangulation.Node(i).Coord(x, y, z);
     local_transform.Transforms(x, y, z);
-    nodes.push_back(mbtool.find_or_create_node({x, y, z}));
+    nodes.push_back(snap ? mbtool.find_or_snap_node({x, y, z})
+                         : mbtool.find_or_create_node({x, y, z}));
+  }
+}
+
+// snapped nodes for the triangulation nodes on the face's edges only, others
+// are left null. a face replaced by a coincident one never gets its inside
+// nodes, which nothing would use
+void BrepFaceter::create_boundary_nodes(entity_vector &nodes,
+                                        const TopoDS_Face &face,
+                                        const Handle(Poly_Triangulation) & triangulation,
+                                        const TopLoc_Location &location)
+{
+  const gp_Trsf &local_transform = location;
+  nodes.assign(triangulation->NbNodes(), 0);
+  for (TopExp_Explorer ex(face, TopAbs_EDGE); ex.More(); ex.Next())
+  {
+    Handle(Poly_PolygonOnTriangulation) polygon =
+        BRep_Tool::PolygonOnTriangulation(TopoDS::Edge(ex.Current()), triangulation, location);
+    if (polygon.IsNull())
+      continue;
+
+    for (int line : polygon->Nodes())
+    {
+      moab::EntityHandle &node = nodes.at(line - 1);
+      if (node != 0)
+        continue;
+
+      Standard_Real x, y, z;
+      triangulation->Node(line).Coord(x, y, z);
+      local_transform.Transforms(x, y, z);
+      node = mbtool.find_or_snap_node({x, y, z});
+    }
   }
 }
 
@@ -274,11 +651,55 @@ void BrepFaceter::create_surface_triangles(entity_vector &triangles,
         connections[2] == connections[0])
     {
       degenerate_triangle_count += 1;
+      continue;
     }
-    else
+
+    // the nodes of stitched curves along each side of the triangle
+    std::array<entity_vector, 3> inserted;
+    int split_sides = 0, split_side = 0;
+    for (int side = 0; side < 3; side++)
+    {
+      inserted[side] = segment_insertions(connections[side], connections[(side + 1) % 3]);
+      if (!inserted[side].empty())
+      {
+        split_sides += 1;
+        split_side = side;
+      }
+    }
+
+    if (split_sides == 0)
     {
       triangles.push_back(mbtool.create_triangle(connections));
     }
+    else if (split_sides == 1)
+    {
+      // fanned from the opposite corner, keeping the triangle's orientation
+      entity_vector along{connections[split_side]};
+      along.insert(along.end(), inserted[split_side].begin(), inserted[split_side].end());
+      along.push_back(connections[(split_side + 1) % 3]);
+      const moab::EntityHandle apex = connections[(split_side + 2) % 3];
+      for (size_t i = 1; i < along.size(); i++)
+      {
+        triangles.push_back(mbtool.create_triangle({along[i - 1], along[i], apex}));
+      }
+    }
+    else
+    {
+      // a corner between split sides would fan into slivers, so the triangle
+      // is fanned from its centroid instead
+      entity_vector polygon;
+      for (int side = 0; side < 3; side++)
+      {
+        polygon.push_back(connections[side]);
+        polygon.insert(polygon.end(), inserted[side].begin(), inserted[side].end());
+      }
+      const moab::EntityHandle centre =
+          mbtool.create_node_at_centroid({connections.begin(), connections.end()});
+      for (size_t i = 0; i < polygon.size(); i++)
+      {
+        triangles.push_back(mbtool.create_triangle({polygon[i], polygon[(i + 1) % polygon.size()], centre}));
+      }
+    }
   }
 }
 
@@ -299,16 +720,316 @@ void BrepFaceter::perform_faceting(const FacetingTolerance &facet_tol)
   }
 }
 
+void BrepFaceter::merge_coincident_faces(const TopTools_HSequenceOfShape &shape_list)
+{
+  // faces no other face has matched yet, by their sorted corner nodes.
+  // snapping makes the corners of coincident faces of different solids
+  // share nodes, however their edges were discretized
+  std::vector<FaceMeshInfo> faces;
+  std::vector<bool> matched;
+  std::map<entity_vector, std::vector<size_t>> unmatched;
+  int merged_count = 0;
+  int rejected_count = 0;
+
+  std::vector<size_t> solids = meshMerge.solids;
+  std::sort(solids.begin(), solids.end());
+  solids.erase(std::unique(solids.begin(), solids.end()), solids.end());
+
+  for (size_t solid : solids)
+  {
+    TopTools_IndexedMapOfShape solid_faces;
+    TopExp::MapShapes(shape_list.Value((int)solid + 1), TopAbs_FACE, solid_faces);
+
+    for (int i = 1; i <= solid_faces.Extent(); i++)
+    {
+      const TopoDS_Face &face = TopoDS::Face(solid_faces(i));
+      // faces already shared with another of the solids are glued
+      if (!snappedFaces.Add(face))
+        continue;
+
+      TopLoc_Location location;
+      Handle(Poly_Triangulation) triangulation = BRep_Tool::Triangulation(face, location);
+      if (triangulation.IsNull() || triangulation->NbNodes() < 1)
+        continue;
+
+      entity_vector nodes;
+      create_boundary_nodes(nodes, face, triangulation, location);
+      FaceMeshInfo info = describe_face(face, solid, triangulation, location, nodes);
+
+      entity_vector corners;
+      for (const EdgeNodes &edge : info.edges)
+      {
+        corners.push_back(edge.ordered.front());
+        corners.push_back(edge.ordered.back());
+      }
+      std::sort(corners.begin(), corners.end());
+      corners.erase(std::unique(corners.begin(), corners.end()), corners.end());
+      if (corners.empty())
+        continue;
+
+      const size_t index = faces.size();
+      faces.push_back(std::move(info));
+      matched.push_back(false);
+      const FaceMeshInfo &current = faces.back();
+
+      std::vector<size_t> &candidates = unmatched[corners];
+      std::vector<EdgeMatch> matches;
+      auto kept = candidates.begin();
+      bool rejected = false;
+      for (; kept != candidates.end(); ++kept)
+      {
+        const FaceMeshInfo &other = faces[*kept];
+        if (other.solid == solid)
+          continue;
+        if (same_region(other, current, meshMerge.tolerance) &&
+            match_edges(current, other, meshMerge.tolerance, matches))
+          break;
+        rejected = true;
+      }
+
+      if (kept == candidates.end())
+      {
+        candidates.push_back(index);
+        rejected_count += rejected ? 1 : 0;
+        continue;
+      }
+
+      alias_face(current, faces[*kept], matches);
+      matched[index] = matched[*kept] = true;
+      merged_count += 1;
+      // an interface is between two solids only
+      candidates.erase(kept);
+    }
+  }
+
+  stitch_curves(faces);
+  const int partly_count = warn_partly_coincident(faces, matched);
+
+  spdlog::info("{} coincident faces merged in mesh space", merged_count);
+  if (rejected_count > 0)
+  {
+    spdlog::warn("{} faces share their corners with a face they don't coincide with.", rejected_count);
+  }
+  if (partly_count > 0)
+  {
+    spdlog::warn("{} faces partly coincide with a face of another solid, and are left non-conformal to it.",
+                 partly_count);
+  }
+}
+
+void BrepFaceter::alias_face(const FaceMeshInfo &replaced, const FaceMeshInfo &kept,
+                             const std::vector<EdgeMatch> &matches)
+{
+  // the kept face's triangles are used for both solids, so the replaced face
+  // is seen from the other side when its surface runs the other way
+  aliases.Bind(replaced.face, kept.face);
+  if (replaced.normal.Dot(kept.normal) < 0)
+  {
+    reversedAliases.Add(replaced.face);
+  }
+
+  // the edges of the replaced face are also used by the other faces of its
+  // solid, which must share the kept face's curves to be watertight
+  for (size_t i = 0; i < replaced.edges.size(); i++)
+  {
+    const EdgeNodes &edge = replaced.edges[i];
+    const EdgeNodes &match = kept.edges[matches[i].edge];
+    if (aliases.IsBound(edge.edge) || resolve(match.edge).IsSame(edge.edge))
+      continue;
+
+    aliases.Bind(edge.edge, match.edge);
+    if (!matches[i].same_direction)
+    {
+      reversedAliases.Add(edge.edge);
+    }
+
+    // the edges were discretized separately, so the curve gets the nodes of
+    // both once every face has been described
+    const TopoDS_Shape &curve = resolve(match.edge);
+    if (!stitchedCurves.IsBound(curve))
+    {
+      stitchedCurves.Bind(curve, entity_vector());
+    }
+
+    TopoDS_Vertex replaced_vertices[2], kept_vertices[2];
+    TopExp::Vertices(edge.edge, replaced_vertices[0], replaced_vertices[1]);
+    TopExp::Vertices(match.edge, kept_vertices[0], kept_vertices[1]);
+    for (const TopoDS_Vertex &vertex : replaced_vertices)
+    {
+      if (vertex.IsNull() || aliases.IsBound(vertex))
+        continue;
+      for (const TopoDS_Vertex &other : kept_vertices)
+      {
+        if (!other.IsNull() && !resolve(other).IsSame(vertex) &&
+            vertex_node(vertex) == vertex_node(other))
+        {
+          aliases.Bind(vertex, other);
+          break;
+        }
+      }
+    }
+  }
+}
+
+void BrepFaceter::stitch_curves(const std::vector<FaceMeshInfo> &faces)
+{
+  // the nodes along each stitched curve, from every face's polyline of it,
+  // placed by how far along their own polyline they are
+  NCollection_DataMap<TopoDS_Shape, std::vector<entity_vector>, TopTools_ShapeMapHasher> polylines;
+  NCollection_DataMap<TopoDS_Shape, std::vector<std::pair<double, moab::EntityHandle>>, TopTools_ShapeMapHasher> placed;
+  for (const FaceMeshInfo &info : faces)
+  {
+    for (const EdgeNodes &edge : info.edges)
+    {
+      const TopoDS_Shape &curve = resolve(edge.edge);
+      if (!stitchedCurves.IsBound(curve))
+        continue;
+
+      entity_vector nodes = edge.ordered;
+      std::vector<double> fractions = fractions_along(edge.points);
+      if (reversed_alias(edge.edge))
+      {
+        std::reverse(nodes.begin(), nodes.end());
+        std::reverse(fractions.begin(), fractions.end());
+        for (double &fraction : fractions)
+        {
+          fraction = 1 - fraction;
+        }
+      }
+
+      if (!placed.IsBound(curve))
+      {
+        placed.Bind(curve, std::vector<std::pair<double, moab::EntityHandle>>());
+        polylines.Bind(curve, std::vector<entity_vector>());
+      }
+      for (size_t i = 0; i < nodes.size(); i++)
+      {
+        placed.ChangeFind(curve).emplace_back(fractions[i], nodes[i]);
+      }
+      polylines.ChangeFind(curve).push_back(std::move(nodes));
+    }
+  }
+
+  for (decltype(placed)::Iterator it(placed); it.More(); it.Next())
+  {
+    std::vector<std::pair<double, moab::EntityHandle>> along = it.Value();
+    std::stable_sort(along.begin(), along.end(),
+                     [](const auto &lhs, const auto &rhs)
+                     { return lhs.first < rhs.first; });
+
+    // a closed curve ends at the node it starts from
+    const entity_vector &first = polylines.Find(it.Key()).front();
+    const bool closed = first.front() == first.back();
+
+    entity_vector curve_nodes;
+    std::unordered_map<moab::EntityHandle, size_t> position;
+    for (const auto &node : along)
+    {
+      if (position.emplace(node.second, curve_nodes.size()).second)
+      {
+        curve_nodes.push_back(node.second);
+      }
+    }
+    if (closed)
+    {
+      curve_nodes.push_back(curve_nodes.front());
+    }
+
+    // the nodes each segment of the polylines has to take in
+    for (const entity_vector &nodes : polylines.Find(it.Key()))
+    {
+      for (size_t i = 1; i < nodes.size(); i++)
+      {
+        const size_t from = position.at(nodes[i - 1]);
+        const size_t to = closed && i + 1 == nodes.size() ? curve_nodes.size() - 1
+                                                          : position.at(nodes[i]);
+        // polylines that cross each other's nodes can't be stitched
+        if (to <= from || to == from + 1)
+          continue;
+
+        entity_vector inserted(curve_nodes.begin() + (long)from + 1, curve_nodes.begin() + (long)to);
+        if (nodes[i - 1] > nodes[i])
+        {
+          std::reverse(inserted.begin(), inserted.end());
+        }
+        segmentInsertions.emplace(std::make_pair(std::min(nodes[i - 1], nodes[i]),
+                                                 std::max(nodes[i - 1], nodes[i])),
+                                  std::move(inserted));
+      }
+    }
+
+    stitchedCurves.ChangeFind(it.Key()) = std::move(curve_nodes);
+  }
+}
+
+int BrepFaceter::warn_partly_coincident(const std::vector<FaceMeshInfo> &faces,
+                                        const std::vector<bool> &matched) const
+{
+  // unmatched faces of different solids meeting at a node, where some of
+  // one lies on the other, e.g. a face against several smaller ones
+  std::unordered_map<moab::EntityHandle, std::vector<size_t>> faces_at;
+  for (size_t i = 0; i < faces.size(); i++)
+  {
+    if (matched[i])
+      continue;
+    for (const EdgeNodes &edge : faces[i].edges)
+    {
+      for (moab::EntityHandle node : edge.ordered)
+      {
+        std::vector<size_t> &at = faces_at[node];
+        if (at.empty() || at.back() != i)
+          at.push_back(i);
+      }
+    }
+  }
+
+  int count = 0;
+  for (size_t i = 0; i < faces.size(); i++)
+  {
+    if (matched[i])
+      continue;
+
+    std::set<size_t> neighbours;
+    for (const EdgeNodes &edge : faces[i].edges)
+    {
+      for (moab::EntityHandle node : edge.ordered)
+      {
+        for (size_t other : faces_at.at(node))
+        {
+          if (faces[other].solid != faces[i].solid)
+            neighbours.insert(other);
+        }
+      }
+    }
+
+    for (size_t other : neighbours)
+    {
+      if (lies_partly_on(faces[i].face, faces[other].face, meshMerge.tolerance))
+      {
+        spdlog::warn("A face of solid {} partly coincides with a face of solid {}, but they don't share a boundary.",
+                     faces[i].solid, faces[other].solid);
+        count += 1;
+        break;
+      }
+    }
+  }
+  return count;
+}
+
 void BrepFaceter::populate_all_surfaces()
 {
-  // Note: surface meshsets have actually been created early, but they are
-  // populated here, and edge and vertex meshsets are created here.
+  // Note: surface meshsets have actually been created before this, but they
+  // are populated here, and edge and vertex meshsets are created here.
 
   for (MapFaceToSurface::Iterator it(surfaceMap); it.More(); it.Next())
   {
     const TopoDS_Face &face = it.Key();
     moab::EntityHandle surface = it.Value();
 
+    // meshed as the face it coincides with
+    if (aliases.IsBound(face))
+      continue;
+
     populate_surface(surface, face);
   }
 
@@ -343,12 +1064,19 @@ entity_vector BrepFaceter::facet(const TopTools_HSequenceOfShape &shape_list,
                                  const FacetingTolerance &facet_tol)
 {
   spdlog::info("Creating surfaces");
-  // build surfaceMap (with early creations of surface meshsets) so we have a
-  // set of unique faces for faceting
+  // build surfaceMap so we have a set of unique faces for faceting
   create_surfaces(shape_list);
 
   spdlog::info("Performing faceting");
   perform_faceting(facet_tol);
+
+  if (meshMerge.enabled())
+  {
+    spdlog::info("Merging coincident faces in mesh space");
+    merge_coincident_faces(shape_list);
+  }
+  create_surface_meshsets();
+
   spdlog::info("Populating surfaces");
   populate_all_surfaces();
 
@@ -407,23 +1135,59 @@ void add_single_material(MBTool &mbtool, const entity_vector &volumes,
   mbtool.add_group(add_mat_prefix(single_material), volumes);
 }
 
-entity_vector sew_and_facet2(TopoDS_Shape &shape, const FacetingTolerance &facet_tol, MBTool &mbtool)
+entity_vector sew_and_facet2(TopoDS_Shape &shape, const FacetingTolerance &facet_tol, MBTool &mbtool,
+                             const MeshMergeOptions &mesh_merge)
 {
+  // the top-level shapes, as the merger numbers them, each hold a run of
+  // the solids faceted
+  std::vector<TopoDS_Shape> children;
+  if (shape.ShapeType() == TopAbs_COMPOUND || shape.ShapeType() == TopAbs_COMPSOLID)
+  {
+    for (TopoDS_Iterator it(shape); it.More(); it.Next())
+    {
+      children.push_back(it.Value());
+    }
+  }
+  else
+  {
+    children.push_back(shape);
+  }
+
   TopTools_HSequenceOfShape shape_list;
-  for (TopExp_Explorer solids(shape, TopAbs_SOLID); solids.More(); solids.Next())
+  std::vector<size_t> first_solid_of_child;
+  for (const TopoDS_Shape &child : children)
   {
-    // sew together all the curves
-    BRepOffsetAPI_Sewing sew;
-    sew.Add(solids.Current());
-    sew.Perform();
+    first_solid_of_child.push_back((size_t)shape_list.Length());
+    for (TopExp_Explorer solids(child, TopAbs_SOLID); solids.More(); solids.Next())
+    {
+      // sew together all the curves
+      BRepOffsetAPI_Sewing sew;
+      sew.Add(solids.Current());
+      sew.Perform();
 
-    // insert into the list
-    shape_list.Append(sew.SewedShape());
+      // insert into the list
+      shape_list.Append(sew.SewedShape());
+    }
   }
+  first_solid_of_child.push_back((size_t)shape_list.Length());
 
   spdlog::info("Facetting {} solids", shape_list.Length());
 
-  BrepFaceter bf(mbtool);
+  std::vector<size_t> merge_solids;
+  for (size_t child : mesh_merge.solids)
+  {
+    if (child >= children.size())
+    {
+      spdlog::error("Shape {} selected for mesh merging, but there are only {}", child, children.size());
+      std::exit(1);
+    }
+    for (size_t solid = first_solid_of_child[child]; solid < first_solid_of_child[child + 1]; solid++)
+    {
+      merge_solids.push_back(solid);
+    }
+  }
+
+  BrepFaceter bf(mbtool, MeshMergeOptions(mesh_merge.tolerance, std::move(merge_solids)));
   return bf.facet(shape_list, facet_tol);
 }
 
@@ -452,7 +1216,8 @@ void read_materials_list(std::string text_file, std::vector<std::string> &mat_li
 
 void brep_faceter(std::string brep_file, std::string materials_list_file,
                   const FacetingTolerance &facet_tol, std::string h5m_file,
-                  bool add_mat_ids, double scale_factor)
+                  bool add_mat_ids, double scale_factor,
+                  const MeshMergeOptions &mesh_merge)
 {
   TopoDS_Shape shape;
   BRep_Builder builder;
@@ -465,9 +1230,11 @@ void brep_faceter(std::string brep_file, std::string materials_list_file,
   // TODO: review use of GEOMETRY_RESABS
   mbtool.set_faceting_tol_tag(facet_tol.lin_def_tol);
   mbtool.set_scale_factor(scale_factor);
+  if (mesh_merge.enabled())
+    mbtool.set_snap_tolerance(mesh_merge.tolerance);
 
   spdlog::info("Begin faceting");
-  entity_vector volumes = sew_and_facet2(shape, facet_tol, mbtool);
+  entity_vector volumes = sew_and_facet2(shape, facet_tol, mbtool, mesh_merge);
 
   spdlog::info("Adding materials to volumes");
   add_materials(mbtool, volumes, materials_list);
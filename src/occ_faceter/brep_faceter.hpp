@@ -2,6 +2,8 @@
 #define BREP_FACETER_HPP
 
 #include <string>
+#include <utility>
+#include <vector>
 
 #include "TopoDS_Shape.hxx"
 
@@ -17,7 +19,27 @@ struct FacetingTolerance
       : lin_def_tol(lin_def_tol), is_relative(!is_absolute), ang_def_tol(ang_def_tol) {}
 };
 
-entity_vector sew_and_facet2(TopoDS_Shape &shape, const FacetingTolerance &facet_tol, MBTool &mbtool);
+// solids made conformal in mesh space instead of by gluing: their nodes are
+// snapped together within the tolerance, and each face coinciding with a face
+// of another of these solids is replaced by that face, with its triangulation.
+// where the two were discretized differently along an edge, the triangles on
+// each side take in the other's nodes. faces coinciding with only part of a
+// face are left non-conformal, with a warning each.
+// sew_and_facet2 takes the indices of top-level shapes, which may hold several
+// solids, and BrepFaceter the indices of the solids within them
+struct MeshMergeOptions
+{
+  double tolerance;
+  std::vector<size_t> solids;
+
+  MeshMergeOptions(double tolerance = 0, std::vector<size_t> solids = {})
+      : tolerance(tolerance), solids(std::move(solids)) {}
+
+  bool enabled() const { return tolerance > 0 && !solids.empty(); }
+};
+
+entity_vector sew_and_facet2(TopoDS_Shape &shape, const FacetingTolerance &facet_tol, MBTool &mbtool,
+                             const MeshMergeOptions &mesh_merge = MeshMergeOptions());
 
 void read_materials_list(std::string text_file, std::vector<std::string> &mat_list);
 void add_materials(MBTool &mbtool, const entity_vector &volumes, const std::vector<std::string> &mat_list);
@@ -25,6 +47,7 @@ void add_single_material(MBTool &mbtool, const entity_vector &volumes, const std
 
 void brep_faceter(std::string brep_file, std::string json_file,
                   const FacetingTolerance &facet_tol, std::string h5m_file,
-                  bool add_mat_ids, double scale_factor);
+                  bool add_mat_ids, double scale_factor,
+                  const MeshMergeOptions &mesh_merge = MeshMergeOptions());
 
 #endif // BREP_FACETER_HH
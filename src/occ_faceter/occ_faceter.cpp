@@ -17,6 +17,8 @@ void occ_faceter(std::string input_brep_file,
                  bool tol_is_absolute,
                  double ang_deflection_tol,
                  double scale_factor,
+                 double mesh_merge_tolerance,
+                 std::vector<size_t> mesh_merge_solids,
                  bool logging)
 {
   if (logging)
@@ -51,6 +53,11 @@ void occ_faceter(std::string input_brep_file,
     spdlog::error("Angular deflection tolerance ({}) should not be negative", ang_deflection_tol);
     std::exit(1);
   }
+  if (!mesh_merge_solids.empty() && mesh_merge_tolerance <= 0)
+  {
+    spdlog::error("Mesh merge tolerance ({}) should be positive", mesh_merge_tolerance);
+    std::exit(1);
+  }
 
   FacetingTolerance facet_tol(lin_deflection_tol, tol_is_absolute, ang_deflection_tol);
 
@@ -63,7 +70,11 @@ void occ_faceter(std::string input_brep_file,
   spdlog::info("  tol_is_absolute (false -> lin_deflection_tol is relative to the edge length): {}", tol_is_absolute);
   spdlog::info("  ang_deflection_tol: {}", ang_deflection_tol);
   spdlog::info("  scale_factor: {}", scale_factor);
+  spdlog::info("  mesh_merge_tolerance: {}", mesh_merge_tolerance);
+  spdlog::info("  mesh_merge_solids: {}", mesh_merge_solids.size());
   spdlog::info("");
 
-  brep_faceter(input_brep_file, materials_file, facet_tol, output_h5m_file, add_mat_ids, scale_factor);
+  MeshMergeOptions mesh_merge(mesh_merge_tolerance, std::move(mesh_merge_solids));
+
+  brep_faceter(input_brep_file, materials_file, facet_tol, output_h5m_file, add_mat_ids, scale_factor, mesh_merge);
 }
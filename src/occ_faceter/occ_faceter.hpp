@@ -2,8 +2,13 @@
 #define OCC_FACETER_HH
 
 #include <string>
+#include <vector>
 
-// Function to facet a geometry and save it to a MOAB h5m file
+// Function to facet a geometry and save it to a MOAB h5m file. The solids in
+// the top-level shapes mesh_merge_solids (numbered as the merger numbers them)
+// are made conformal after faceting instead: their nodes within
+// mesh_merge_tolerance are merged, and coincident faces between them are
+// replaced by one surface
 void occ_faceter(std::string input_brep_file,
                  std::string output_h5m_file,
                  std::string materials_file,
@@ -11,6 +16,8 @@ void occ_faceter(std::string input_brep_file,
                  bool tol_is_absolute,
                  double ang_deflection_tol,
                  double scale_factor,
+                 double mesh_merge_tolerance,
+                 std::vector<size_t> mesh_merge_solids,
                  bool logging);
 
 #endif // OCC_FACETER_HH
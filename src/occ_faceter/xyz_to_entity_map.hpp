@@ -3,6 +3,8 @@
 
 #include <array>
 #include <unordered_map>
+#include <utility>
+#include <vector>
 
 #include "moab/EntityHandle.hpp"
 
@@ -33,4 +35,30 @@ struct std::hash<xyz_coords>
 
 typedef std::unordered_map<xyz_coords, moab::EntityHandle> coordinates_to_entity_map;
 
+// index of a cell in a uniform grid over space
+struct grid_cell
+{
+    std::array<long long, 3> index;
+};
+
+inline bool operator==(const grid_cell &lhs, const grid_cell &rhs)
+{
+    return lhs.index == rhs.index;
+}
+
+template <>
+struct std::hash<grid_cell>
+{
+    std::size_t operator()(grid_cell const &c) const noexcept
+    {
+        std::size_t h1 = std::hash<long long>{}(c.index[0]);
+        std::size_t h2 = std::hash<long long>{}(c.index[1]);
+        std::size_t h3 = std::hash<long long>{}(c.index[2]);
+        return h1 ^ (h2 << 1) ^ (h3 << 2);
+    }
+};
+
+// nodes, and their coordinates, in each cell of a grid
+typedef std::unordered_map<grid_cell, std::vector<std::pair<std::array<double, 3>, moab::EntityHandle>>> grid_to_entities_map;
+
 #endif // XYZ_TO_ENTITY_MAP_HPP
@@ -427,78 +427,91 @@ collect_warnings(const Message_Report *report, int &warnings)
 	}
 }
 
-class ProgressTimeout : public Message_ProgressIndicator
+void ProgressTimeout::begin(unsigned timeout_millisecs)
 {
-	typedef std::chrono::steady_clock clock;
-	std::chrono::time_point<clock> startedat_, expireat_;
-	std::unique_ptr<Message_ProgressScope> scope_;
-	bool expired_;
+	startedat_ = clock::now();
+	has_timeout_ = timeout_millisecs > 0;
+	if (has_timeout_)
+	{
+		expireat_ = startedat_ + std::chrono::milliseconds{timeout_millisecs};
+	}
+}
 
-public:
-	ProgressTimeout() : expired_{false} {}
+double ProgressTimeout::duration_secs() const
+{
+	return std::chrono::duration<double>(clock::now() - startedat_).count();
+}
 
-	void begin(BOPAlgo_Algo &algo, unsigned timeout_millisecs)
+Standard_Boolean ProgressTimeout::UserBreak()
+{
+	if (expired_ || (abandoned_ && *abandoned_))
 	{
-		startedat_ = clock::now();
-		if (timeout_millisecs > 0)
-		{
-			scope_ = std::make_unique<Message_ProgressScope>(Start(), nullptr, 0);
-			expireat_ = startedat_ + std::chrono::milliseconds{timeout_millisecs};
-		}
+		return true;
 	}
-
-	bool expired() const
+	else if (!has_timeout_ || clock::now() < expireat_)
 	{
-		return expired_;
+		return false;
 	}
-
-	double duration_secs() const
+	else
 	{
-		return std::chrono::duration<double>(clock::now() - startedat_).count();
+		expired_ = true;
+		return true;
 	}
+}
 
-	void Show(const Message_ProgressScope &, const Standard_Boolean) override {}
+// what paving a pair of solids, and the boolean operations on them, found.
+// shared by classifying and imprinting so both treat a pair the same
+struct paved_pair
+{
+	// set when paving and every operation asked for succeeded
+	bool built;
+	bool timed_out;
 
-	Standard_Boolean UserBreak() override
-	{
-		if (expired_)
-		{
-			return true;
-		}
-		else if (clock::now() < expireat_)
-		{
-			return false;
-		}
-		else
-		{
-			expired_ = true;
-			return true;
-		}
-	}
+	double fuzzy_value, pave_time_seconds;
+	int num_filler_warnings, num_common_warnings, num_section_warnings;
+
+	// whether the common shape has a solid, and whether that is some volume
+	// overlapping. touching is only known when classifying or overlapping
+	// by a negative volume
+	bool common_solid, overlap, touching;
+
+	TopoDS_Shape common, cut, cut21;
+	double vol_common, vol_cut, vol_cut12;
 };
 
-intersect_result classify_solid_intersection(
+// pave shape and tool then find what they have in common. the cut shapes
+// are built when the common shape has a solid or when imprinting, which
+// wants them whatever the solids share, and the section when classifying
+// solids that don't overlap
+static paved_pair
+pave_solids(
 	const TopoDS_Shape &shape, const TopoDS_Shape &tool,
 	double fuzzy_value, unsigned pave_time_millisecs,
-	const char *msg)
+	const std::atomic<bool> *abandoned, bool classify, bool imprint)
 {
-	using std::chrono::duration;
-	using std::chrono::steady_clock;
-
-	intersect_result result = {
-		intersect_status::failed,
-		// fuzzy value
+	paved_pair result = {
+		// built, timed out
+		false,
+		false,
+		// fuzzy value, pave time
 		0.0,
+		-1.0,
 		// number of warnings
 		0,
 		0,
 		0,
+		// common solid, overlap, touching
+		false,
+		false,
+		false,
+		// shapes
+		{},
+		{},
+		{},
 		// volumes
 		-1.0,
 		-1.0,
 		-1.0,
-		// pave time
-		-1.0,
 	};
 
 	// create here as they need a longer scope than the pave filler
@@ -519,10 +532,11 @@ intersect_result classify_solid_intersection(
 		filler.SetArguments(args);
 	}
 
-	timeout.begin(filler, pave_time_millisecs);
+	timeout.begin(pave_time_millisecs);
+	timeout.abandon_when(abandoned);
 
 	// this can be a very expensive call, e.g. 10+ seconds
-	filler.Perform();
+	filler.Perform(timeout.Start());
 
 	result.pave_time_seconds = timeout.duration_secs();
 	result.fuzzy_value = filler.FuzzyValue();
@@ -536,7 +550,7 @@ intersect_result classify_solid_intersection(
 
 	if (timeout.expired())
 	{
-		result.status = intersect_status::timeout;
+		result.timed_out = true;
 		return result;
 	}
 
@@ -553,15 +567,18 @@ intersect_result classify_solid_intersection(
 	{
 		return result;
 	}
+	result.common = op.Shape();
 
 	TopExp_Explorer ex;
-	ex.Init(op.Shape(), TopAbs_SOLID);
-	if (ex.More())
+	ex.Init(result.common, TopAbs_SOLID);
+	result.common_solid = ex.More();
+
+	if (result.common_solid || imprint)
 	{
 		// OCCT (version 7.5) appears to occasionally come back with a
 		// negative volume. it appears to do this when the two solids have
 		// non-trivial faces that are within the given tolerance/fuzzy value
-		result.vol_common = volume_of_shape_maybe_neg(op.Shape());
+		result.vol_common = volume_of_shape_maybe_neg(result.common);
 
 		op.SetOperation(BOPAlgo_CUT);
 		op.Build();
@@ -569,7 +586,8 @@ intersect_result classify_solid_intersection(
 		{
 			return result;
 		}
-		result.vol_cut = volume_of_shape(op.Shape());
+		result.cut = op.Shape();
+		result.vol_cut = volume_of_shape(result.cut);
 
 		op.SetOperation(BOPAlgo_CUT21);
 		op.Build();
@@ -577,175 +595,247 @@ intersect_result classify_solid_intersection(
 		{
 			return result;
 		}
-		result.vol_cut12 = volume_of_shape(op.Shape());
+		result.cut21 = op.Shape();
+		result.vol_cut12 = volume_of_shape(result.cut21);
+	}
 
-		if (result.vol_common < 0)
-		{
-			// ensure the this negative volume is "small", relative to the
-			// input shapes, as we only expect this to happen along the
-			// boundary of shapes
-			const double limit = std::min(result.vol_cut, result.vol_cut12) * 0.1;
-			if (limit < -result.vol_common)
-			{
-				throw std::runtime_error("negative volume too large");
-			}
-
-			// until this is fixed upstream in OCCT, recording them as
-			// touching seems to be best. an alternative would be to fail, and
-			// let the caller retry with stricter tolerance (which tends to
-			// succeed). touching seems best as we later steps want to know
-			// which solids are close to each other and therefore need to
-			// considered during merging
-			result.status = intersect_status::touching;
-		}
-		else
+	if (result.common_solid && result.vol_common < 0)
+	{
+		// ensure the this negative volume is "small", relative to the
+		// input shapes, as we only expect this to happen along the
+		// boundary of shapes
+		const double limit = std::min(result.vol_cut, result.vol_cut12) * 0.1;
+		if (limit < -result.vol_common)
 		{
-			result.status = intersect_status::overlap;
+			throw std::runtime_error("negative volume too large");
 		}
-		return result;
-	}
 
-	op.SetOperation(BOPAlgo_SECTION);
-	op.Build();
-	collect_warnings(op.GetReport().get(), result.num_section_warnings);
-	if (!op.HasErrors())
+		// until this is fixed upstream in OCCT, recording them as
+		// touching seems to be best. an alternative would be to fail, and
+		// let the caller retry with stricter tolerance (which tends to
+		// succeed). touching seems best as we later steps want to know
+		// which solids are close to each other and therefore need to
+		// considered during merging
+		result.touching = true;
+	}
+	else if (result.common_solid)
 	{
+		result.overlap = true;
+	}
+	else if (classify)
+	{
+		op.SetOperation(BOPAlgo_SECTION);
+		op.Build();
+		collect_warnings(op.GetReport().get(), result.num_section_warnings);
+		if (op.HasErrors())
+		{
+			return result;
+		}
 		ex.Init(op.Shape(), TopAbs_VERTEX);
-		result.status = ex.More() ? intersect_status::touching : intersect_status::distinct;
+		result.touching = ex.More();
 	}
 
+	result.built = true;
 	return result;
 }
 
-static inline bool shape_has_verticies(TopoDS_Shape shape)
+static intersect_result
+intersect_of(const paved_pair &paved)
 {
-	TopExp_Explorer ex;
-	ex.Init(shape, TopAbs_VERTEX);
-	return ex.More();
-}
-
-imprint_result perform_solid_imprinting(
-	const TopoDS_Shape &shape, const TopoDS_Shape &tool, double fuzzy_value)
-{
-	imprint_result result = {
-		imprint_status::failed,
-		// fuzzy value
-		0.0,
+	intersect_result result = {
+		intersect_status::failed,
+		paved.fuzzy_value,
 		// number of warnings
-		0,
-		0,
-		0,
+		paved.num_filler_warnings,
+		paved.num_common_warnings,
+		paved.num_section_warnings,
 		// volumes
 		-1.0,
 		-1.0,
 		-1.0,
-		// shapes
-		{},
-		{},
+		paved.pave_time_seconds,
 	};
 
-	BOPAlgo_PaveFiller filler;
-	filler.SetRunParallel(false);
-	filler.SetFuzzyValue(fuzzy_value);
-	filler.SetNonDestructive(true);
-
+	if (paved.timed_out)
 	{
-		TopTools_ListOfShape args;
-		args.Append(shape);
-		args.Append(tool);
-		filler.SetArguments(args);
+		result.status = intersect_status::timeout;
+		return result;
 	}
 
-	// this can be a very expensive call, e.g. 10+ seconds
-	filler.Perform();
-
+	if (paved.common_solid)
 	{
-		Handle(Message_Report) report = filler.GetReport();
-		collect_warnings(report.get(), result.num_filler_warnings);
-		// this report is merged into the following reports
-		report->Clear();
+		result.vol_common = paved.vol_common;
+		result.vol_cut = paved.vol_cut;
+		result.vol_cut12 = paved.vol_cut12;
 	}
 
-	result.fuzzy_value = filler.FuzzyValue();
-	if (filler.HasErrors())
+	if (!paved.built)
 	{
 		return result;
 	}
 
-	TopoDS_Shape common;
+	if (paved.overlap)
+	{
+		result.status = intersect_status::overlap;
+	}
+	else
+	{
+		result.status = paved.touching ? intersect_status::touching : intersect_status::distinct;
+	}
+	return result;
+}
+
+// merge the common volume into the larger of the cut shapes in result,
+// leaving the status as failed if that fails
+static void merge_common_volume(imprint_result &result, const TopoDS_Shape &common)
+{
+	const bool merge_into_shape = result.vol_cut >= result.vol_cut12;
 
+	boolean_op op{
+		BOPAlgo_FUSE,
+		merge_into_shape ? result.shape : result.tool,
+		common};
+	// fuzzy stuff has already been done so no need to introduce more error
+	// op.SetFuzzyValue(filler.FuzzyValue());
+	// the above created distinct shapes, so we are free to modify here
+
+	op.Build();
+	collect_warnings(op.GetReport().get(), result.num_fuse_warnings);
+	if (op.HasErrors())
 	{
-		boolean_op op{filler, BOPAlgo_COMMON, shape, tool};
-		op.SetFuzzyValue(filler.FuzzyValue());
-		op.Build();
-		collect_warnings(op.GetReport().get(), result.num_common_warnings);
-		if (op.HasErrors())
-		{
-			return result;
-		}
-		common = op.Shape();
-		result.vol_common = volume_of_shape(common);
+		return;
+	}
 
-		op.SetOperation(BOPAlgo_CUT);
-		op.Build();
-		if (op.HasErrors())
-		{
-			return result;
-		}
+	if (merge_into_shape)
+	{
+		result.status = imprint_status::merge_into_shape;
 		result.shape = op.Shape();
-		result.vol_cut = volume_of_shape(result.shape);
-
-		op.SetOperation(BOPAlgo_CUT21);
-		op.Build();
-		if (op.HasErrors())
-		{
-			return result;
-		}
+	}
+	else
+	{
+		result.status = imprint_status::merge_into_tool;
 		result.tool = op.Shape();
-		result.vol_cut12 = volume_of_shape(result.tool);
+	}
+}
+
+// a break leaves the pair unbuilt, so times out as failed
+static imprint_result
+imprint_of(const paved_pair &paved)
+{
+	imprint_result result = {
+		imprint_status::failed,
+		paved.fuzzy_value,
+		// number of warnings
+		paved.num_filler_warnings,
+		paved.num_common_warnings,
+		0,
+		// volumes
+		paved.vol_common,
+		paved.vol_cut,
+		paved.vol_cut12,
+		// shapes
+		paved.cut,
+		paved.cut21,
+	};
+
+	if (!paved.built)
+	{
+		return result;
 	}
 
-	if (!shape_has_verticies(common))
+	if (!paved.overlap)
 	{
 		result.status = imprint_status::distinct;
 	}
 	else
 	{
-		// merge the common volume into the larger shape
-		const bool merge_into_shape = result.vol_cut >= result.vol_cut12;
+		merge_common_volume(result, paved.common);
+	}
+	return result;
+}
 
-		boolean_op op{
-			BOPAlgo_FUSE,
-			merge_into_shape ? result.shape : result.tool,
-			common};
-		// fuzzy stuff has already been done so no need to introduce more error
-		// op.SetFuzzyValue(filler.FuzzyValue());
-		// the above created distinct shapes, so we are free to modify here
+intersect_result classify_solid_intersection(
+	const TopoDS_Shape &shape, const TopoDS_Shape &tool,
+	double fuzzy_value, unsigned pave_time_millisecs,
+	const char *msg, const std::atomic<bool> *abandoned)
+{
+	return intersect_of(pave_solids(shape, tool, fuzzy_value, pave_time_millisecs, abandoned, true, false));
+}
 
-		op.Build();
-		collect_warnings(op.GetReport().get(), result.num_fuse_warnings);
-		if (op.HasErrors())
-		{
-			return result;
-		}
+imprint_result perform_solid_imprinting(
+	const TopoDS_Shape &shape, const TopoDS_Shape &tool, double fuzzy_value,
+	unsigned pave_time_millisecs)
+{
+	return imprint_of(pave_solids(shape, tool, fuzzy_value, pave_time_millisecs, nullptr, false, true));
+}
 
-		if (merge_into_shape)
-		{
-			result.status = imprint_status::merge_into_shape;
-			result.shape = op.Shape();
-		}
-		else
+classify_imprint_result classify_and_imprint_solids(
+	const TopoDS_Shape &shape, const TopoDS_Shape &tool,
+	double fuzzy_value, unsigned pave_time_millisecs,
+	const std::atomic<bool> *abandoned)
+{
+	// the expensive paving, and the booleans, both results share
+	const paved_pair paved = pave_solids(shape, tool, fuzzy_value, pave_time_millisecs, abandoned, true, true);
+	return {intersect_of(paved), imprint_of(paved)};
+}
+
+#ifdef INCLUDE_TESTS
+#include <BRepBuilderAPI_Transform.hxx>
+#include <BRepPrimAPI_MakeBox.hxx>
+#include <BRep_Tool.hxx>
+#include <TopExp.hxx>
+#include <TopoDS.hxx>
+#include <TopoDS_Compound.hxx>
+#include <TopTools_IndexedMapOfShape.hxx>
+
+// enough cubes that paving them against another takes well over a
+// millisecond
+static TopoDS_Shape
+grid_of_cubes()
+{
+	TopoDS_Builder builder;
+	TopoDS_Compound grid;
+	builder.MakeCompound(grid);
+	for (int i = 0; i < 20; i++)
+	{
+		for (int j = 0; j < 20; j++)
 		{
-			result.status = imprint_status::merge_into_tool;
-			result.tool = op.Shape();
+			builder.Add(grid, cube_at(i * 2, j * 2, 0, 1));
 		}
 	}
-
-	return result;
+	return grid;
 }
 
-#ifdef INCLUDE_TESTS
-#include <BRepPrimAPI_MakeBox.hxx>
+TEST_CASE("classify_solid_intersection")
+{
+	using Catch::Approx;
+
+	SECTION("two touching objects")
+	{
+		const auto s1 = cube_at(0, 0, 0, 5), s2 = cube_at(5, 0, 0, 5);
+
+		const auto res = classify_solid_intersection(s1, s2, 0.5, 0, nullptr);
+		CHECK(res.status == intersect_status::touching);
+	}
+
+	SECTION("two objects overlapping at corner")
+	{
+		const auto s1 = cube_at(0, 0, 0, 5), s2 = cube_at(4, 4, 4, 2);
+
+		const auto res = classify_solid_intersection(s1, s2, 0.1, 0, nullptr);
+		REQUIRE(res.status == intersect_status::overlap);
+
+		CHECK(res.vol_common == Approx(1));
+		CHECK(res.vol_cut == Approx(5 * 5 * 5 - 1));
+		CHECK(res.vol_cut12 == Approx(2 * 2 * 2 - 1));
+	}
+
+	SECTION("a tiny time limit stops the pave filler")
+	{
+		const auto res = classify_solid_intersection(grid_of_cubes(), cube_at(-1, -1, 0.5, 42), 0.1, 1, nullptr);
+		CHECK((res.status == intersect_status::timeout || res.status == intersect_status::failed));
+	}
+}
 
 TEST_CASE("perform_solid_imprinting")
 {
@@ -841,6 +931,65 @@ TEST_CASE("perform_solid_imprinting")
 	}
 }
 
+TEST_CASE("classify_and_imprint_solids")
+{
+	using Catch::Approx;
+
+	SECTION("two touching objects")
+	{
+		const auto s1 = cube_at(0, 0, 0, 5), s2 = cube_at(5, 0, 0, 5);
+
+		const auto res = classify_and_imprint_solids(s1, s2, 0.5, 0);
+		REQUIRE(res.intersect.status == intersect_status::touching);
+		REQUIRE(res.imprint.status == imprint_status::distinct);
+
+		CHECK(volume_of_shape(res.imprint.shape) == Approx(5 * 5 * 5));
+		CHECK(volume_of_shape(res.imprint.tool) == Approx(5 * 5 * 5));
+	}
+
+	SECTION("touching objects are imprinted as by perform_solid_imprinting")
+	{
+		const auto s1 = cube_at(0, 0, 0, 5), s2 = cube_at(5, 1, 1, 2);
+
+		const auto res = classify_and_imprint_solids(s1, s2, 0.1, 0);
+		const auto imprinted = perform_solid_imprinting(s1, s2, 0.1);
+		REQUIRE(res.intersect.status == intersect_status::touching);
+		REQUIRE(res.imprint.status == imprint_status::distinct);
+		REQUIRE(imprinted.status == imprint_status::distinct);
+
+		// the face s2 touches is split where it does
+		TopTools_IndexedMapOfShape faces, imprinted_faces;
+		TopExp::MapShapes(res.imprint.shape, TopAbs_FACE, faces);
+		TopExp::MapShapes(imprinted.shape, TopAbs_FACE, imprinted_faces);
+		CHECK(faces.Extent() > 6);
+		CHECK(faces.Extent() == imprinted_faces.Extent());
+	}
+
+	SECTION("two objects overlapping at corner")
+	{
+		const auto s1 = cube_at(0, 0, 0, 5), s2 = cube_at(4, 4, 4, 2);
+
+		const auto res = classify_and_imprint_solids(s1, s2, 0.1, 0);
+		REQUIRE(res.intersect.status == intersect_status::overlap);
+		REQUIRE(res.imprint.status == imprint_status::merge_into_shape);
+
+		// same as classifying and imprinting separately
+		CHECK(res.intersect.vol_common == Approx(1));
+		CHECK(res.intersect.vol_cut == Approx(5 * 5 * 5 - 1));
+		CHECK(res.intersect.vol_cut12 == Approx(2 * 2 * 2 - 1));
+
+		CHECK(volume_of_shape(res.imprint.shape) == Approx(5 * 5 * 5));
+		CHECK(volume_of_shape(res.imprint.tool) == Approx(2 * 2 * 2 - 1));
+	}
+
+	SECTION("a tiny time limit stops the pave filler")
+	{
+		const auto res = classify_and_imprint_solids(grid_of_cubes(), cube_at(-1, -1, 0.5, 42), 0.1, 1);
+		CHECK((res.intersect.status == intersect_status::timeout || res.intersect.status == intersect_status::failed));
+		CHECK(res.imprint.status == imprint_status::failed);
+	}
+}
+
 #include "salome/geom_gluer.hxx"
 
 static inline size_t shape_count_uniq(TopoDS_Shape shape, TopAbs_ShapeEnum what)
@@ -897,4 +1046,100 @@ TEST_CASE("salome_glue_shape")
 	}
 }
 
+TEST_CASE("salome_glue_shape_onto")
+{
+	SECTION("replacing the middle of three glued cubes")
+	{
+		TopoDS_Builder builder;
+		TopoDS_Compound input;
+		builder.MakeCompound(input);
+		for (int i = 0; i < 3; i++)
+		{
+			builder.Add(input, cube_at(i, 0, 0, 1));
+		}
+		const TopoDS_Shape glued = salome_glue_shape(input, 1e-6);
+
+		std::vector<TopoDS_Shape> solids;
+		for (TopoDS_Iterator it{glued}; it.More(); it.Next())
+		{
+			solids.push_back(it.Value());
+		}
+		REQUIRE(solids.size() == 3);
+
+		// the outer cubes are left as they are
+		TopoDS_Compound fixed, replacement;
+		builder.MakeCompound(fixed);
+		builder.Add(fixed, solids[0]);
+		builder.Add(fixed, solids[2]);
+		builder.MakeCompound(replacement);
+		builder.Add(replacement, cube_at(1, 0, 0, 1));
+
+		TopTools_IndexedMapOfShape fixed_verticies;
+		TopExp::MapShapes(fixed, TopAbs_VERTEX, fixed_verticies);
+		std::vector<Standard_Real> tolerances;
+		for (int i = 1; i <= fixed_verticies.Extent(); i++)
+		{
+			tolerances.push_back(BRep_Tool::Tolerance(TopoDS::Vertex(fixed_verticies(i))));
+		}
+
+		const TopoDS_Shape result = salome_glue_shape_onto(replacement, fixed, 1e-6);
+		REQUIRE(shape_count_uniq(result, TopAbs_SOLID) == 1);
+
+		// the new cube reuses the fixed cubes' faces rather than copies
+		TopoDS_Compound model;
+		builder.MakeCompound(model);
+		builder.Add(model, solids[0]);
+		builder.Add(model, result);
+		builder.Add(model, solids[2]);
+		CHECK(shape_count_uniq(model, TopAbs_VERTEX) == 16);
+		CHECK(shape_count_uniq(model, TopAbs_EDGE) == 28);
+		CHECK(shape_count_uniq(model, TopAbs_FACE) == 16);
+
+		// and the fixed cubes weren't modified, not even their tolerances
+		TopTools_IndexedMapOfShape after;
+		TopExp::MapShapes(fixed, TopAbs_VERTEX, after);
+		REQUIRE(after.Extent() == fixed_verticies.Extent());
+		for (int i = 1; i <= after.Extent(); i++)
+		{
+			CHECK(after(i).IsSame(fixed_verticies(i)));
+			CHECK(BRep_Tool::Tolerance(TopoDS::Vertex(after(i))) == tolerances[(size_t)i - 1]);
+		}
+	}
+}
+
+TEST_CASE("salome_glue_shape coincidence checks")
+{
+	TopoDS_Builder builder;
+	TopoDS_Compound input;
+	builder.MakeCompound(input);
+	builder.Add(input, cube_at(0, 0, 0, 1));
+
+	SECTION("a shared face is checked in closed form")
+	{
+		builder.Add(input, cube_at(1, 0, 0, 1));
+
+		glue_stats stats;
+		salome_glue_shape(input, 1e-3, &stats);
+		CHECK(stats.num_face_groups == 1);
+		CHECK(stats.num_glued_faces == 2);
+		CHECK(stats.num_analytic_checks > 0);
+	}
+
+	SECTION("a slightly tilted face is projected")
+	{
+		// tilted about the middle of the shared face, so its edges across the
+		// axis are half a thousandth out: within tolerance, but not parallel
+		// to it over their length
+		gp_Trsf tilt;
+		tilt.SetRotation(gp_Ax1{gp_Pnt{1, 0, 0.5}, gp::DY()}, 1e-3);
+		builder.Add(input, BRepBuilderAPI_Transform{cube_at(1, 0, 0, 1), tilt, Standard_True}.Shape());
+
+		glue_stats stats;
+		salome_glue_shape(input, 1e-3, &stats);
+		CHECK(stats.num_face_groups == 1);
+		CHECK(stats.num_glued_faces == 2);
+		CHECK(stats.num_projections > 0);
+	}
+}
+
 #endif
@@ -1,4 +1,10 @@
+#ifndef GEOMETRY_HPP
+#define GEOMETRY_HPP
+
 #include <sys/types.h>
+#include <atomic>
+#include <chrono>
+#include <memory>
 #include <vector>
 #include <ostream>
 
@@ -6,6 +12,8 @@
 #include <TopoDS_Shape.hxx>
 #include <BRepCheck_Status.hxx>
 #include <BRepAlgoAPI_BooleanOperation.hxx>
+#include <Message_ProgressIndicator.hxx>
+#include <Message_ProgressScope.hxx>
 
 std::ostream &operator<<(std::ostream &str, TopAbs_ShapeEnum type);
 std::ostream &operator<<(std::ostream &str, BRepCheck_Status type);
@@ -31,6 +39,44 @@ struct document
 
 class BOPAlgo_PaveFiller;
 
+// progress indicator that requests a break once a wall-clock limit has passed,
+// or another thread has abandoned the work. may be shared between threads
+class ProgressTimeout : public Message_ProgressIndicator
+{
+protected:
+	typedef std::chrono::steady_clock clock;
+
+private:
+	std::chrono::time_point<clock> startedat_, expireat_;
+	bool has_timeout_;
+	std::atomic<bool> expired_;
+	const std::atomic<bool> *abandoned_;
+
+public:
+	ProgressTimeout() : has_timeout_{false}, expired_{false}, abandoned_{nullptr} {}
+
+	// timeout of zero disables timeout handling. the limit is only checked
+	// by algorithms performed with a range from Start()
+	void begin(unsigned timeout_millisecs);
+
+	// also break once the flag is set, when non-null. doesn't count as expiring
+	void abandon_when(const std::atomic<bool> *abandoned)
+	{
+		abandoned_ = abandoned;
+	}
+
+	bool expired() const
+	{
+		return expired_;
+	}
+
+	double duration_secs() const;
+
+	void Show(const Message_ProgressScope &, const Standard_Boolean) override {}
+
+	Standard_Boolean UserBreak() override;
+};
+
 class boolean_op : public BRepAlgoAPI_BooleanOperation
 {
 public:
@@ -102,11 +148,12 @@ struct intersect_result
 	double pave_time_seconds;
 };
 
-// pave time of zero disables timeout handling
+// pave time of zero disables timeout handling. setting abandoned, when
+// non-null, stops the pave filler early with a failed result
 intersect_result classify_solid_intersection(
 	const TopoDS_Shape &shape, const TopoDS_Shape &tool,
 	double fuzzy_value, unsigned pave_time_millisecs,
-	const char *msg);
+	const char *msg, const std::atomic<bool> *abandoned = nullptr);
 
 enum class imprint_status
 {
@@ -139,5 +186,32 @@ struct imprint_result
 	TopoDS_Shape shape, tool;
 };
 
+// pave time of zero disables timeout handling, a pair that takes longer is
+// failed. a common volume that OCCT finds small and negative is taken as
+// the solids touching, as by classify_solid_intersection, so distinct
 imprint_result perform_solid_imprinting(
-	const TopoDS_Shape &shape, const TopoDS_Shape &tool, double fuzzy_value);
+	const TopoDS_Shape &shape, const TopoDS_Shape &tool, double fuzzy_value,
+	unsigned pave_time_millisecs = 0);
+
+struct classify_imprint_result
+{
+	intersect_result intersect;
+
+	// as perform_solid_imprinting gives, so merged only when
+	// intersect.status == overlap, otherwise distinct with the cut shapes
+	// (or failed)
+	imprint_result imprint;
+
+	// set by callers that found the result in a pair_cache
+	bool cached = false;
+};
+
+// classify_solid_intersection and perform_solid_imprinting, sharing one pave
+// filler and the boolean results between them. pave time of zero disables timeout handling, and abandoned is
+// as for classify_solid_intersection
+classify_imprint_result classify_and_imprint_solids(
+	const TopoDS_Shape &shape, const TopoDS_Shape &tool,
+	double fuzzy_value, unsigned pave_time_millisecs,
+	const std::atomic<bool> *abandoned = nullptr);
+
+#endif // GEOMETRY_HPP
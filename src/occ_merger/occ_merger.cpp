@@ -1,6 +1,12 @@
 #include <algorithm>
+#include <atomic>
 #include <cassert>
+#include <chrono>
 #include <cmath>
+#include <exception>
+#include <string>
+#include <utility>
+#include <vector>
 
 #include <spdlog/spdlog.h>
 
@@ -15,12 +21,217 @@
 #include "salome/geom_gluer.hxx"
 
 #include "geometry.hpp"
+#include "occ_merger.hpp"
 #include "utils.hpp"
 
-void occ_merger(
+// reports the innermost phase and overall fraction done to a callback, at
+// most every report_interval. the callback returning false or throwing, or the
+// time limit expiring, cancels the merge
+class merge_progress : public ProgressTimeout
+{
+	static constexpr std::chrono::milliseconds report_interval{250};
+
+	merge_progress_callback callback_;
+	clock::time_point last_report_;
+	std::atomic<bool> cancelled_;
+	std::exception_ptr error_;
+
+public:
+	merge_progress(merge_progress_callback callback)
+		: callback_{std::move(callback)}, cancelled_{false} {}
+
+	// called with the indicator's lock held
+	void Show(const Message_ProgressScope &scope, const Standard_Boolean force) override
+	{
+		if (!callback_)
+		{
+			return;
+		}
+		const auto now = clock::now();
+		if (!force && now - last_report_ < report_interval)
+		{
+			return;
+		}
+		last_report_ = now;
+
+		const char *name = scope.Name();
+		bool keep_going = false;
+		try
+		{
+			keep_going = callback_(name ? name : "", GetPosition());
+		}
+		// this may be a worker thread, which an exception mustn't leave, so
+		// it's kept for rethrow_callback_error
+		catch (...)
+		{
+			if (!error_)
+			{
+				error_ = std::current_exception();
+			}
+		}
+		if (!keep_going)
+		{
+			cancelled_ = true;
+		}
+	}
+
+	Standard_Boolean UserBreak() override
+	{
+		return cancelled_ || ProgressTimeout::UserBreak();
+	}
+
+	// rethrow what the callback threw, if it did
+	void rethrow_callback_error() const
+	{
+		if (error_)
+		{
+			std::rethrow_exception(error_);
+		}
+	}
+};
+
+// limits too large to hold are clamped to the largest, about 49 days
+static unsigned
+time_limit_to_millisecs(double time_limit_secs)
+{
+	if (!(time_limit_secs >= 0))
+	{
+		spdlog::error("time limit ({}) should not be negative", time_limit_secs);
+		std::exit(1);
+	}
+	return millisecs_to_unsigned(time_limit_secs * 1000);
+}
+
+// returns the number of shapes whose volume changed by more than the
+// tolerance (relative to the smaller volume)
+static size_t
+count_volume_changes(
+	const std::vector<TopoDS_Shape> &before,
+	const std::vector<TopoDS_Shape> &after,
+	double dist_tolerance)
+{
+	size_t num_changed = 0;
+	for (size_t i = 0; i < before.size(); i++)
+	{
+		const double
+			v1 = volume_of_shape(before[i]),
+			v2 = volume_of_shape(after[i]),
+			mn = std::min(v1, v2) * dist_tolerance;
+
+		if (std::fabs(v1 - v2) > mn)
+		{
+			spdlog::warn("non-trivial change in volume during merge, {} => {}", v1, v2);
+			num_changed += 1;
+		}
+	}
+	return num_changed;
+}
+
+static TopoDS_Compound
+make_compound(const std::vector<TopoDS_Shape> &shapes)
+{
+	TopoDS_Compound compound;
+	TopoDS_Builder builder;
+	builder.MakeCompound(compound);
+	for (const auto &shape : shapes)
+	{
+		builder.Add(compound, shape);
+	}
+	return compound;
+}
+
+// check the glued result still has the input's solids, with the same
+// volumes, collecting them into out. logs what's wrong and returns false
+// otherwise
+static bool
+check_merged_solids(
+	const document &inp,
+	const TopoDS_Shape &result,
+	double dist_tolerance,
+	document &out)
+{
+	if (result.IsNull())
+	{
+		spdlog::error("Failed to merge shapes");
+		return false;
+	}
+
+	for (TopoDS_Iterator it{result}; it.More(); it.Next())
+	{
+		out.solid_shapes.emplace_back(it.Value());
+	}
+
+	if (inp.solid_shapes.size() != out.solid_shapes.size())
+	{
+		spdlog::error(
+			"Number of shapes changed after merge, {} => {}",
+			inp.solid_shapes.size(),
+			out.solid_shapes.size());
+		return false;
+	}
+
+	return count_volume_changes(inp.solid_shapes, out.solid_shapes, dist_tolerance) == 0;
+}
+
+// check the glued result still has the input's solids, and write it out.
+// exits on failure
+static void
+write_merged_solids(
+	const document &inp,
+	const TopoDS_Shape &result,
+	double dist_tolerance,
+	const std::string &output_brep_file)
+{
+	document out;
+	if (!check_merged_solids(inp, result, dist_tolerance, out))
+	{
+		std::exit(1);
+	}
+
+	spdlog::info("Writing .brep output file {}", output_brep_file);
+
+	out.write_brep_file(output_brep_file.c_str());
+}
+
+std::string check_merge_options(const merge_options &options)
+{
+	const bool grouped = !options.groups.empty();
+	const bool with_fallback = options.mesh_fallback || !options.mesh_solids.empty();
+	if (options.partitioned && grouped)
+	{
+		return "partitioned and grouped merging can't be combined";
+	}
+	if (with_fallback && grouped)
+	{
+		return "mesh merging can't be combined with grouped merging";
+	}
+	if (options.cross_solid_only && grouped)
+	{
+		return "cross-solid merging can't be combined with grouped merging";
+	}
+	if (options.near_miss_tolerance > 0 && grouped)
+	{
+		return "near misses can't be reported with grouped merging";
+	}
+
+	if (options.engine != "salome" && options.engine != "fuse")
+	{
+		return fmt::format("unknown merge engine \"{}\", expected \"salome\" or \"fuse\"", options.engine);
+	}
+	if (options.engine == "fuse" &&
+		(options.partitioned || grouped || options.imprint || with_fallback ||
+		 options.cross_solid_only || options.near_miss_tolerance > 0))
+	{
+		return "the fuse engine doesn't support the gluer's other options";
+	}
+	return {};
+}
+
+glue_stats occ_merger(
 	std::string input_brep_file,
 	std::string output_brep_file,
-	double dist_tolerance,
+	const merge_options &options,
+	merge_progress_callback progress_callback,
 	bool logging)
 {
 	if (logging)
@@ -32,77 +243,398 @@ void occ_merger(
 		spdlog::set_level(spdlog::level::err);
 	}
 
+	const double dist_tolerance = options.dist_tolerance;
+	const std::vector<size_t> &groups = options.groups;
+
 	spdlog::info("");
 	spdlog::info("Starting occ_merger:");
 	spdlog::info("  input_brep_file: {}", input_brep_file);
 	spdlog::info("  output_brep_file: {}", output_brep_file);
 	spdlog::info("  dist_tolerance: {}", dist_tolerance);
+	spdlog::info("  partitioned: {}", options.partitioned);
+	spdlog::info("  groups: {}", groups.size());
+	spdlog::info("  imprint: {}", options.imprint);
+	spdlog::info("  mesh_solids: {}", options.mesh_solids.size());
+	spdlog::info("  mesh_fallback: {}", options.mesh_fallback);
+	spdlog::info("  cross_solid_only: {}", options.cross_solid_only);
+	spdlog::info("  near_miss_tolerance: {}", options.near_miss_tolerance);
+	spdlog::info("  engine: {}", options.engine);
+	spdlog::info("  time_limit_secs: {}", options.time_limit_secs);
 	spdlog::info("");
 
+	const unsigned time_limit_millisecs = time_limit_to_millisecs(options.time_limit_secs);
+
+	const std::string invalid = check_merge_options(options);
+	if (!invalid.empty())
+	{
+		spdlog::error("{}", invalid);
+		std::exit(1);
+	}
+	const bool fuse = options.engine == "fuse";
+	const bool with_fallback = options.mesh_fallback || !options.mesh_solids.empty();
+
 	document inp;
 	inp.load_brep_file(input_brep_file.c_str());
 
 	spdlog::info("Brep loaded");
 
-	TopoDS_Compound merged;
-	TopoDS_Builder builder;
-	builder.MakeCompound(merged);
-	for (const auto &shape : inp.solid_shapes)
+	if (!groups.empty() && groups.size() != inp.solid_shapes.size())
 	{
-		builder.Add(merged, shape);
+		spdlog::error(
+			"{} groups given for {} solids",
+			groups.size(), inp.solid_shapes.size());
+		std::exit(1);
 	}
 
+	TopoDS_Shape merged = make_compound(inp.solid_shapes);
+
 	spdlog::info("Compound created");
 
-	document out;
+	glue_stats stats;
+
+	// the time limit is on the merge, not on loading the model
+	merge_progress progress{std::move(progress_callback)};
+	progress.begin(time_limit_millisecs);
 
+	TopoDS_Shape result;
+	try
 	{
+		Message_ProgressScope scope{progress.Start(), "merge", options.imprint ? 2 : 1};
+
+		// a cancelled merge propagates glue_cancelled to the caller
+		if (options.imprint)
+		{
+			spdlog::info("Imprinting shapes");
+
+			merged = salome_imprint_shape(merged, dist_tolerance, &stats, scope.Next());
+		}
+
 		spdlog::info("Merging shapes");
 
-		const auto result = salome_glue_shape(merged, dist_tolerance);
+		if (fuse)
+		{
+			result = fuse_glue_shape(merged, dist_tolerance, &stats, scope.Next());
+		}
+		else if (!groups.empty())
+		{
+			result = salome_glue_shape_grouped(merged, groups, dist_tolerance, &stats, scope.Next());
+		}
+		else if (with_fallback)
+		{
+			result = salome_glue_shape_with_fallback(
+				merged, options.mesh_solids, options.mesh_fallback, dist_tolerance, &stats, scope.Next(),
+				options.cross_solid_only, options.near_miss_tolerance);
+		}
+		else if (options.partitioned)
+		{
+			result = salome_glue_shape_partitioned(
+				merged, dist_tolerance, &stats, scope.Next(), options.cross_solid_only, options.near_miss_tolerance);
+		}
+		else
+		{
+			result = salome_glue_shape(
+				merged, dist_tolerance, &stats, scope.Next(), options.cross_solid_only, options.near_miss_tolerance);
+		}
+	}
+	catch (glue_cancelled &)
+	{
+		// the caller would rather see why their callback failed
+		progress.rethrow_callback_error();
+		throw;
+	}
+	// a callback that threw on its last report may not have been noticed
+	progress.rethrow_callback_error();
+
+	spdlog::info("Peak memory use {:.1f} MiB", stats.peak_memory_bytes / (1024. * 1024.));
+	if (options.near_miss_tolerance > dist_tolerance)
+	{
+		spdlog::info("{} near misses within {}", stats.near_misses.size(), options.near_miss_tolerance);
+	}
 
-		if (result.IsNull())
+	write_merged_solids(inp, result, dist_tolerance, output_brep_file);
+
+	return stats;
+}
+
+glue_stats occ_merger_incremental(
+	std::string previous_brep_file,
+	std::string replacement_brep_file,
+	std::vector<size_t> replaced_solids,
+	std::string output_brep_file,
+	double dist_tolerance,
+	bool logging)
+{
+	if (logging)
+	{
+		spdlog::set_level(spdlog::level::debug);
+	}
+	else
+	{
+		spdlog::set_level(spdlog::level::err);
+	}
+
+	spdlog::info("");
+	spdlog::info("Starting occ_merger_incremental:");
+	spdlog::info("  previous_brep_file: {}", previous_brep_file);
+	spdlog::info("  replacement_brep_file: {}", replacement_brep_file);
+	spdlog::info("  replaced_solids: {}", replaced_solids.size());
+	spdlog::info("  output_brep_file: {}", output_brep_file);
+	spdlog::info("  dist_tolerance: {}", dist_tolerance);
+	spdlog::info("");
+
+	document doc, replacements;
+	doc.load_brep_file(previous_brep_file.c_str());
+	replacements.load_brep_file(replacement_brep_file.c_str());
+
+	spdlog::info("Breps loaded");
+
+	if (replacements.solid_shapes.size() != replaced_solids.size())
+	{
+		spdlog::error(
+			"{} solids given as replacements for {} solids",
+			replacements.solid_shapes.size(),
+			replaced_solids.size());
+		std::exit(1);
+	}
+
+	std::vector<bool> is_replaced(doc.solid_shapes.size(), false);
+	for (const auto idx : replaced_solids)
+	{
+		if (idx >= doc.solid_shapes.size())
 		{
-			spdlog::error("Failed to merge shapes");
+			spdlog::error(
+				"replaced solid {} out of range, model has {} solids",
+				idx, doc.solid_shapes.size());
 			std::exit(1);
 		}
+		if (is_replaced[idx])
+		{
+			spdlog::error("solid {} replaced more than once", idx);
+			std::exit(1);
+		}
+		is_replaced[idx] = true;
+	}
 
-		for (TopoDS_Iterator it{result}; it.More(); it.Next())
+	TopoDS_Builder builder;
+	TopoDS_Compound unchanged, changed;
+	builder.MakeCompound(unchanged);
+	builder.MakeCompound(changed);
+	for (size_t i = 0; i < doc.solid_shapes.size(); i++)
+	{
+		if (!is_replaced[i])
 		{
-			out.solid_shapes.emplace_back(it.Value());
+			builder.Add(unchanged, doc.solid_shapes[i]);
 		}
 	}
+	for (const auto &shape : replacements.solid_shapes)
+	{
+		builder.Add(changed, shape);
+	}
 
-	if (inp.solid_shapes.size() != out.solid_shapes.size())
+	spdlog::info("Merging replaced shapes");
+
+	glue_stats stats;
+	const auto result = salome_glue_shape_onto(changed, unchanged, dist_tolerance, &stats);
+
+	std::vector<TopoDS_Shape> merged;
+	for (TopoDS_Iterator it{result}; it.More(); it.Next())
+	{
+		merged.emplace_back(it.Value());
+	}
+
+	if (merged.size() != replacements.solid_shapes.size())
 	{
 		spdlog::error(
 			"Number of shapes changed after merge, {} => {}",
-			inp.solid_shapes.size(),
-			out.solid_shapes.size());
+			replacements.solid_shapes.size(),
+			merged.size());
 		std::exit(1);
 	}
 
-	size_t num_changed = 0;
-	for (size_t i = 0; i < inp.solid_shapes.size(); i++)
+	if (count_volume_changes(replacements.solid_shapes, merged, dist_tolerance) > 0)
 	{
-		const double
-			v1 = volume_of_shape(inp.solid_shapes[i]),
-			v2 = volume_of_shape(out.solid_shapes[i]),
-			mn = std::min(v1, v2) * dist_tolerance;
+		std::exit(1);
+	}
 
-		if (std::fabs(v1 - v2) > mn)
+	for (size_t i = 0; i < replaced_solids.size(); i++)
+	{
+		doc.solid_shapes[replaced_solids[i]] = merged[i];
+	}
+
+	spdlog::info("Writing .brep output file {}", output_brep_file);
+
+	doc.write_brep_file(output_brep_file.c_str());
+
+	return stats;
+}
+
+glue_detection occ_merger_detect(
+	std::string input_brep_file,
+	double dist_tolerance,
+	bool logging)
+{
+	if (logging)
+	{
+		spdlog::set_level(spdlog::level::debug);
+	}
+	else
+	{
+		spdlog::set_level(spdlog::level::err);
+	}
+
+	spdlog::info("");
+	spdlog::info("Starting occ_merger_detect:");
+	spdlog::info("  input_brep_file: {}", input_brep_file);
+	spdlog::info("  dist_tolerance: {}", dist_tolerance);
+	spdlog::info("");
+
+	document inp;
+	inp.load_brep_file(input_brep_file.c_str());
+
+	spdlog::info("Brep loaded");
+
+	const auto result = salome_detect_glue(make_compound(inp.solid_shapes), dist_tolerance);
+
+	spdlog::info(
+		"detected {} vertex, {} edge and {} face groups",
+		result.vertices.size(), result.edges.size(), result.faces.size());
+
+	return result;
+}
+
+std::vector<glue_stats> occ_merger_sweep(
+	std::string input_brep_file,
+	std::vector<double> dist_tolerances,
+	std::string output_brep_file,
+	double output_dist_tolerance,
+	bool logging)
+{
+	if (logging)
+	{
+		spdlog::set_level(spdlog::level::debug);
+	}
+	else
+	{
+		spdlog::set_level(spdlog::level::err);
+	}
+
+	spdlog::info("");
+	spdlog::info("Starting occ_merger_sweep:");
+	spdlog::info("  input_brep_file: {}", input_brep_file);
+	spdlog::info("  dist_tolerances: {}", dist_tolerances.size());
+	spdlog::info("  output_brep_file: {}", output_brep_file);
+	spdlog::info("  output_dist_tolerance: {}", output_dist_tolerance);
+	spdlog::info("");
+
+	if (dist_tolerances.empty())
+	{
+		spdlog::error("no tolerances to sweep");
+		std::exit(1);
+	}
+
+	int glue_index = -1;
+	if (!output_brep_file.empty())
+	{
+		const auto found = std::find(dist_tolerances.begin(), dist_tolerances.end(), output_dist_tolerance);
+		if (found == dist_tolerances.end())
 		{
-			spdlog::warn("non-trivial change in volume during merge, {} => {}", v1, v2);
-			num_changed += 1;
+			spdlog::error("output tolerance ({}) is not one of the swept tolerances", output_dist_tolerance);
+			std::exit(1);
 		}
+		glue_index = (int)(found - dist_tolerances.begin());
+	}
+
+	document inp;
+	inp.load_brep_file(input_brep_file.c_str());
+
+	spdlog::info("Brep loaded");
+
+	std::vector<glue_stats> stats;
+	const auto result = salome_glue_sweep(
+		make_compound(inp.solid_shapes), dist_tolerances, stats, glue_index);
+
+	for (size_t i = 0; i < dist_tolerances.size(); i++)
+	{
+		spdlog::info(
+			"  {}: {} vertex clusters, {} edge groups, {} face groups",
+			dist_tolerances[i], stats[i].num_vertex_clusters,
+			stats[i].num_edge_groups, stats[i].num_face_groups);
 	}
 
-	if (num_changed > 0)
+	if (glue_index >= 0)
 	{
-		std::exit(1);
+		write_merged_solids(inp, result, output_dist_tolerance, output_brep_file);
 	}
 
-	spdlog::info("Writing .brep output file {}", output_brep_file);
+	return stats;
+}
 
-	out.write_brep_file(output_brep_file.c_str());
+std::vector<merge_benchmark> occ_merger_benchmark(
+	std::string input_brep_file,
+	double dist_tolerance,
+	bool logging)
+{
+	if (logging)
+	{
+		spdlog::set_level(spdlog::level::debug);
+	}
+	else
+	{
+		spdlog::set_level(spdlog::level::err);
+	}
+
+	spdlog::info("");
+	spdlog::info("Starting occ_merger_benchmark:");
+	spdlog::info("  input_brep_file: {}", input_brep_file);
+	spdlog::info("  dist_tolerance: {}", dist_tolerance);
+	spdlog::info("");
+
+	document inp;
+	inp.load_brep_file(input_brep_file.c_str());
+
+	spdlog::info("Brep loaded");
+
+	const TopoDS_Shape merged = make_compound(inp.solid_shapes);
+
+	typedef TopoDS_Shape (*merge_engine)(
+		const TopoDS_Shape &, Standard_Real, glue_stats *, const Message_ProgressRange &);
+	const std::vector<std::pair<std::string, merge_engine>> engines{
+		{"salome", [](const TopoDS_Shape &shape, Standard_Real tolerance, glue_stats *stats,
+					  const Message_ProgressRange &progress)
+		 { return salome_glue_shape(shape, tolerance, stats, progress); }},
+		{"fuse", [](const TopoDS_Shape &shape, Standard_Real tolerance, glue_stats *stats,
+					const Message_ProgressRange &progress)
+		 { return fuse_glue_shape(shape, tolerance, stats, progress); }},
+	};
+
+	std::vector<merge_benchmark> results;
+	for (const auto &[name, engine] : engines)
+	{
+		spdlog::info("Merging shapes with the {} engine", name);
+
+		merge_benchmark run;
+		run.engine = name;
+
+		const auto started = std::chrono::steady_clock::now();
+		const TopoDS_Shape result = engine(merged, dist_tolerance, &run.stats, Message_ProgressRange());
+		run.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - started).count();
+
+		for (const auto &phase : run.stats.phases)
+		{
+			run.memory_bytes = std::max(run.memory_bytes, phase.memory_bytes);
+		}
+
+		document out;
+		run.passed = check_merged_solids(inp, result, dist_tolerance, out);
+
+		spdlog::info(
+			"  {}: {:.2f} s, {:.1f} MiB, {} vertex clusters, {} edge groups, {} face groups{}",
+			name, run.seconds, run.memory_bytes / (1024. * 1024.),
+			run.stats.num_vertex_clusters, run.stats.num_edge_groups, run.stats.num_face_groups,
+			run.passed ? "" : ", failed checks");
+
+		results.push_back(std::move(run));
+	}
+
+	return results;
 }
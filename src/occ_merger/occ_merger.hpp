@@ -1,12 +1,121 @@
 #ifndef OCC_MERGER_HPP
 #define OCC_MERGER_HPP
 
+#include <functional>
 #include <string>
+#include <vector>
 
-// Function to merge shapes from an input BREP file and write the result to an output BREP file
-void occ_merger(
+#include "salome/geom_gluer.hxx"
+
+// Called with the current phase and the fraction of the merge done, return false to cancel. An
+// exception thrown by it cancels the merge and is rethrown to occ_merger's caller
+typedef std::function<bool(const std::string &phase, double fraction)> merge_progress_callback;
+
+// How occ_merger merges. Grouped merging can't be combined with partitioned, mesh or
+// cross-solid merging, or with reporting near misses, and the "fuse" engine supports none of
+// the options after it. check_merge_options enforces this for both the C++ and Python callers
+struct merge_options
+{
+    // vertices, edges and faces closer than this are merged
+    double dist_tolerance = 0.001;
+
+    // "salome", the gluer, or "fuse", which general fuses all the solids at once in parallel
+    std::string engine = "salome";
+
+    // glue clusters of solids whose bounding boxes overlap separately, in parallel
+    bool partitioned = false;
+
+    // the group of each solid, when given solids are glued within each group first, then
+    // across groups
+    std::vector<size_t> groups;
+
+    // split partly coincident faces of touching solids first, so they can be merged
+    bool imprint = false;
+
+    // solids whose clusters are written unglued and listed in the returned mesh_solids, for the
+    // faceter to make conformal instead. Implies partitioned merging
+    std::vector<size_t> mesh_solids;
+
+    // also leave clusters that fail to glue for the faceter. Implies partitioned merging
+    bool mesh_fallback = false;
+
+    // only merge vertices, edges and faces of different solids, skipping the search for them
+    // within each solid
+    bool cross_solid_only = false;
+
+    // when larger than dist_tolerance, the merged result is searched for pairs of vertices,
+    // edges and faces of different solids closer than this that weren't merged, which are
+    // listed in the returned near_misses
+    double near_miss_tolerance = 0;
+
+    // zero disables it, an expired limit throws glue_cancelled
+    double time_limit_secs = 0;
+};
+
+// Why the options can't be combined, or an empty string when they can
+std::string check_merge_options(const merge_options &options);
+
+// Function to merge shapes from an input BREP file and write the result to an output BREP file,
+// returns timings and counters from the gluer. Exits when the options can't be combined. A
+// cancelled merge throws glue_cancelled
+glue_stats occ_merger(
     std::string input_brep_file,
     std::string output_brep_file,
+    const merge_options &options,
+    merge_progress_callback progress_callback,
+    bool logging);
+
+// Re-merge a few replaced solids into a previously merged BREP file. Only the
+// replacements and the solids near them are considered, every other shared
+// face and edge in the model is left as it was
+glue_stats occ_merger_incremental(
+    std::string previous_brep_file,
+    std::string replacement_brep_file,
+    std::vector<size_t> replaced_solids,
+    std::string output_brep_file,
+    double dist_tolerance,
+    bool logging);
+
+// Report which vertices, edges and faces in a BREP file would be merged at the given
+// tolerance, without merging them. Solids are numbered in file order
+glue_detection occ_merger_detect(
+    std::string input_brep_file,
+    double dist_tolerance,
+    bool logging);
+
+// Report what would be merged at each of the tolerances, sharing the search for nearby
+// vertices between them. When an output file is given, the merge at output_dist_tolerance
+// (which must be one of the tolerances) is written to it. Returns stats for each tolerance
+std::vector<glue_stats> occ_merger_sweep(
+    std::string input_brep_file,
+    std::vector<double> dist_tolerances,
+    std::string output_brep_file,
+    double output_dist_tolerance,
+    bool logging);
+
+// One engine's merge of the input in occ_merger_benchmark
+struct merge_benchmark
+{
+    std::string engine;
+
+    // wall time of the merge, without loading or checking
+    double seconds = 0;
+
+    // largest working set seen at the end of a phase of this merge. The high-water
+    // mark in stats is the process's, so includes the engines run before
+    size_t memory_bytes = 0;
+
+    // whether the result kept the input's solids and their volumes
+    bool passed = false;
+
+    glue_stats stats;
+};
+
+// Merge a BREP file with each engine in turn ("salome", then "fuse"), without writing the
+// results, to compare their time, memory use and glued counts on the same input. An engine
+// that fails to merge gives a row that didn't pass
+std::vector<merge_benchmark> occ_merger_benchmark(
+    std::string input_brep_file,
     double dist_tolerance,
     bool logging);
 
@@ -0,0 +1,841 @@
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <exception>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include <spdlog/spdlog.h>
+
+#include <Bnd_Box.hxx>
+#include <BRepBndLib.hxx>
+#include <NCollection_UBTree.hxx>
+#include <NCollection_UBTreeFiller.hxx>
+#include <OSD_Parallel.hxx>
+#include <Standard_Failure.hxx>
+#include <TColStd_ListOfInteger.hxx>
+
+#include "geometry.hpp"
+#include "overlap_checker.hpp"
+#include "utils.hpp"
+
+namespace
+{
+	using BoxTreeFiller = NCollection_UBTreeFiller<Standard_Integer, Bnd_Box>;
+	using BoxTree = BoxTreeFiller::UBTree;
+
+	class BoxSelector : public BoxTree::Selector
+	{
+		const Bnd_Box &box;
+		TColStd_ListOfInteger indicies;
+
+	public:
+		BoxSelector(const Bnd_Box &box) : box{box} {}
+
+		bool Reject(const Bnd_Box &other) const override
+		{
+			return box.IsOut(other);
+		}
+
+		bool Accept(const Standard_Integer &index) override
+		{
+			indicies.Append(index);
+			return true;
+		}
+
+		const TColStd_ListOfInteger &Indices() const
+		{
+			return indicies;
+		}
+	};
+
+	// pairs (a < b) of solids whose boxes, inflated by the fuzzy value so
+	// solids that could touch are included, overlap
+	std::vector<std::pair<size_t, size_t>>
+	find_candidate_pairs(const std::vector<TopoDS_Shape> &solids, double fuzzy_value)
+	{
+		std::vector<Bnd_Box> boxes(solids.size());
+		OSD_Parallel::For(0, (int)solids.size(), [&](int i)
+		{
+			BRepBndLib::Add(solids[i], boxes[i], Standard_False);
+			boxes[i].Enlarge(fuzzy_value);
+		});
+
+		BoxTree tree;
+		{
+			BoxTreeFiller filler(tree);
+			for (size_t i = 0; i < boxes.size(); i++)
+			{
+				if (!boxes[i].IsVoid())
+				{
+					filler.Add((Standard_Integer)i, boxes[i]);
+				}
+			}
+			filler.Fill();
+		}
+
+		std::vector<std::pair<size_t, size_t>> pairs;
+		for (size_t i = 0; i < boxes.size(); i++)
+		{
+			if (boxes[i].IsVoid())
+			{
+				continue;
+			}
+			BoxSelector nearby{boxes[i]};
+			tree.Select(nearby);
+			for (const auto idx : nearby.Indices())
+			{
+				if ((size_t)idx > i)
+				{
+					pairs.emplace_back(i, (size_t)idx);
+				}
+			}
+		}
+		std::sort(pairs.begin(), pairs.end());
+		return pairs;
+	}
+
+	// fingerprints of the document's solids, for looking them up in the cache.
+	// empty without one
+	std::vector<uint64_t>
+	fingerprint_solids(const document &doc, const pair_cache *cache)
+	{
+		std::vector<uint64_t> fingerprints;
+		if (cache && cache->enabled())
+		{
+			fingerprints.resize(doc.solid_shapes.size());
+			OSD_Parallel::For(0, (int)doc.solid_shapes.size(), [&](int i)
+			{
+				fingerprints[i] = shape_fingerprint(doc.solid_shapes[i]);
+			});
+		}
+		return fingerprints;
+	}
+
+	// the document's solids and their fingerprints, where results are cached,
+	// and whether overlapping pairs are imprinted as they're classified
+	struct classify_context
+	{
+		const document &doc;
+		const std::vector<uint64_t> &fingerprints;
+		pair_cache *cache;
+		bool imprint;
+	};
+
+	// a pair that can't be classified is reported as failed, rather than
+	// stopping the rest. the imprint is failed unless asked for and the pair
+	// overlaps. an abandoned attempt fails, and isn't cached
+	classify_imprint_result
+	classify_pair(
+		const classify_context &ctx, size_t a, size_t b,
+		double fuzzy_value, unsigned pave_time_millisecs,
+		const std::atomic<bool> *abandoned)
+	{
+		const bool use_cache = !ctx.fingerprints.empty();
+
+		classify_imprint_result result{};
+		if (use_cache && ctx.cache->lookup(ctx.fingerprints[a], ctx.fingerprints[b], fuzzy_value, result.intersect))
+		{
+			// an imprint cached alongside is looked up when resolving
+			result.cached = true;
+			return result;
+		}
+
+		result.intersect.status = intersect_status::failed;
+		result.intersect.fuzzy_value = fuzzy_value;
+		result.intersect.vol_common = result.intersect.vol_cut = result.intersect.vol_cut12 = -1;
+		result.intersect.pave_time_seconds = -1;
+		// an exception, e.g. running out of memory, may not happen next time
+		// so only results that came back are cached
+		bool returned = false;
+		try
+		{
+			if (ctx.imprint)
+			{
+				result = classify_and_imprint_solids(
+					ctx.doc.solid_shapes[a], ctx.doc.solid_shapes[b], fuzzy_value, pave_time_millisecs,
+					abandoned);
+			}
+			else
+			{
+				result.intersect = classify_solid_intersection(
+					ctx.doc.solid_shapes[a], ctx.doc.solid_shapes[b], fuzzy_value, pave_time_millisecs, nullptr,
+					abandoned);
+			}
+			returned = true;
+		}
+		catch (Standard_Failure &err)
+		{
+			spdlog::warn("classifying solids {} and {} failed: {}", a, b, err.GetMessageString());
+		}
+		catch (std::exception &err)
+		{
+			spdlog::warn("classifying solids {} and {} failed: {}", a, b, err.what());
+		}
+
+		if (use_cache && returned && !(abandoned && *abandoned))
+		{
+			ctx.cache->store(ctx.fingerprints[a], ctx.fingerprints[b], fuzzy_value, result.intersect);
+			if (result.intersect.status == intersect_status::overlap &&
+				result.imprint.status != imprint_status::failed)
+			{
+				ctx.cache->store(ctx.fingerprints[a], ctx.fingerprints[b], fuzzy_value, result.imprint);
+			}
+		}
+		return result;
+	}
+
+	// a result worth keeping, a pair overlapping by no volume isn't
+	bool
+	is_consistent(const intersect_result &result)
+	{
+		switch (result.status)
+		{
+		case intersect_status::distinct:
+		case intersect_status::touching:
+			return true;
+		case intersect_status::overlap:
+			return result.vol_common > 0;
+		default:
+			return false;
+		}
+	}
+
+	// time limit of the retry, growing from the first attempt's. zero stays
+	// unlimited, and limits that grow too large to hold are clamped
+	unsigned
+	retry_time_limit(unsigned pave_time_millisecs, double factor, size_t retry)
+	{
+		if (pave_time_millisecs == 0)
+		{
+			return 0;
+		}
+		return millisecs_to_unsigned(pave_time_millisecs * std::pow(factor, (double)retry + 1));
+	}
+
+	// classify a pair with attempt(fuzzy_value, pave_time_millisecs,
+	// abandoned), working through the retry policy until a result is
+	// consistent. when none is, the first attempt's result is kept.
+	//
+	// concurrent retries run in the pool already running the pairs, as
+	// OSD_Parallel::For nests: they take whatever threads are free, and run
+	// one after another on this one when none are. either way, once a retry
+	// is consistent those after it can't be kept, so any not yet started are
+	// skipped and any running are abandoned
+	template <typename Attempt>
+	classify_imprint_result
+	classify_with_retries(
+		const Attempt &attempt, double fuzzy_value, unsigned pave_time_millisecs,
+		const overlap_retry_policy &retry, size_t &attempts)
+	{
+		const classify_imprint_result first = attempt(fuzzy_value, pave_time_millisecs, nullptr);
+		attempts = 1;
+		if (is_consistent(first.intersect) || retry.fuzzy_values.empty())
+		{
+			return first;
+		}
+
+		const size_t num_retries = retry.fuzzy_values.size();
+		if (retry.concurrent)
+		{
+			std::vector<classify_imprint_result> results(num_retries);
+			std::vector<std::atomic<bool>> abandoned(num_retries);
+			std::vector<char> started(num_retries, false);
+			OSD_Parallel::For(0, (int)num_retries, [&](int i)
+			{
+				if (abandoned[i])
+				{
+					return;
+				}
+				started[i] = true;
+				results[i] = attempt(
+					retry.fuzzy_values[i],
+					retry_time_limit(pave_time_millisecs, retry.timeout_factor, (size_t)i),
+					&abandoned[i]);
+				if (is_consistent(results[i].intersect))
+				{
+					for (size_t j = (size_t)i + 1; j < num_retries; j++)
+					{
+						abandoned[j] = true;
+					}
+				}
+			});
+			for (size_t i = 0; i < num_retries; i++)
+			{
+				if (!started[i])
+				{
+					continue;
+				}
+				attempts += 1;
+				if (is_consistent(results[i].intersect))
+				{
+					return results[i];
+				}
+			}
+			return first;
+		}
+
+		for (size_t i = 0; i < num_retries; i++)
+		{
+			classify_imprint_result result = attempt(
+				retry.fuzzy_values[i],
+				retry_time_limit(pave_time_millisecs, retry.timeout_factor, i),
+				nullptr);
+			attempts += 1;
+			if (is_consistent(result.intersect))
+			{
+				return result;
+			}
+		}
+		return first;
+	}
+}
+
+std::vector<overlap_pair> check_solid_overlaps(
+	const document &doc, double fuzzy_value, unsigned pave_time_millisecs,
+	const overlap_retry_policy &retry,
+	pair_cache *cache,
+	std::vector<imprint_result> *imprints)
+{
+	const auto candidates = find_candidate_pairs(doc.solid_shapes, fuzzy_value);
+	const auto fingerprints = fingerprint_solids(doc, cache);
+	const classify_context ctx{doc, fingerprints, cache, imprints != nullptr};
+	if (imprints)
+	{
+		imprints->assign(candidates.size(), imprint_result{});
+	}
+
+	spdlog::info(
+		"classifying {} candidate pairs of {} solids",
+		candidates.size(), doc.solid_shapes.size());
+
+	std::vector<overlap_pair> pairs(candidates.size());
+	OSD_Parallel::For(0, (int)candidates.size(), [&](int i)
+	{
+		const auto [a, b] = candidates[i];
+		overlap_pair &pair = pairs[i];
+		pair.a = a;
+		pair.b = b;
+
+		const auto started = std::chrono::steady_clock::now();
+		const auto attempt = [&](double fuzzy, unsigned millisecs, const std::atomic<bool> *abandoned)
+		{
+			return classify_pair(ctx, a, b, fuzzy, millisecs, abandoned);
+		};
+		const classify_imprint_result classified = classify_with_retries(
+			attempt, fuzzy_value, pave_time_millisecs, retry, pair.attempts);
+		const intersect_result &result = classified.intersect;
+
+		pair.status = result.status;
+		pair.cached = classified.cached;
+		pair.fuzzy_value = result.fuzzy_value;
+		pair.vol_common = result.vol_common;
+		pair.vol_cut = result.vol_cut;
+		pair.vol_cut12 = result.vol_cut12;
+		pair.pave_seconds = result.pave_time_seconds;
+		if (imprints && result.status == intersect_status::overlap)
+		{
+			(*imprints)[i] = classified.imprint;
+		}
+		pair.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - started).count();
+	});
+
+	return pairs;
+}
+
+std::vector<overlap_pair> occ_overlap_checker(
+	std::string input_brep_file,
+	double fuzzy_value,
+	double pave_time_limit_secs,
+	std::vector<double> retry_fuzzy_values,
+	double retry_timeout_factor,
+	bool concurrent_retries,
+	std::string cache_directory,
+	bool logging)
+{
+	if (logging)
+	{
+		spdlog::set_level(spdlog::level::debug);
+	}
+	else
+	{
+		spdlog::set_level(spdlog::level::err);
+	}
+
+	spdlog::info("");
+	spdlog::info("Starting occ_overlap_checker:");
+	spdlog::info("  input_brep_file: {}", input_brep_file);
+	spdlog::info("  fuzzy_value: {}", fuzzy_value);
+	spdlog::info("  pave_time_limit_secs: {}", pave_time_limit_secs);
+	spdlog::info("  retry_fuzzy_values: {}", retry_fuzzy_values.size());
+	spdlog::info("  retry_timeout_factor: {}", retry_timeout_factor);
+	spdlog::info("  concurrent_retries: {}", concurrent_retries);
+	spdlog::info("  cache_directory: {}", cache_directory);
+	spdlog::info("");
+
+	if (pave_time_limit_secs < 0)
+	{
+		spdlog::error("pave time limit ({}) should not be negative", pave_time_limit_secs);
+		std::exit(1);
+	}
+	if (retry_timeout_factor <= 0)
+	{
+		spdlog::error("retry timeout factor ({}) should be positive", retry_timeout_factor);
+		std::exit(1);
+	}
+
+	overlap_retry_policy retry;
+	retry.fuzzy_values = std::move(retry_fuzzy_values);
+	retry.timeout_factor = retry_timeout_factor;
+	retry.concurrent = concurrent_retries;
+
+	document inp;
+	inp.load_brep_file(input_brep_file.c_str());
+
+	spdlog::info("Brep loaded");
+
+	pair_cache cache{cache_directory};
+	const auto pairs = check_solid_overlaps(
+		inp, fuzzy_value, millisecs_to_unsigned(pave_time_limit_secs * 1000), retry, &cache);
+	if (cache.enabled())
+	{
+		spdlog::info("{} cached results reused, {} intersections run", cache.hits(), cache.misses());
+		cache.save();
+	}
+
+	size_t counts[5] = {}, num_retried = 0;
+	for (const auto &pair : pairs)
+	{
+		counts[(int)pair.status] += 1;
+		num_retried += pair.attempts > 1 ? 1 : 0;
+	}
+	if (num_retried)
+	{
+		spdlog::info("{} pairs were retried", num_retried);
+	}
+	spdlog::info(
+		"{} overlapping, {} touching and {} distinct pairs, {} failed and {} timed out",
+		counts[(int)intersect_status::overlap], counts[(int)intersect_status::touching],
+		counts[(int)intersect_status::distinct], counts[(int)intersect_status::failed],
+		counts[(int)intersect_status::timeout]);
+
+	return pairs;
+}
+
+std::vector<size_t> schedule_overlap_rounds(const std::vector<overlap_pair> &pairs)
+{
+	// rounds each solid is already in
+	std::unordered_map<size_t, std::vector<bool>> busy;
+	std::vector<size_t> rounds(pairs.size());
+	for (size_t i = 0; i < pairs.size(); i++)
+	{
+		auto &busy_a = busy[pairs[i].a];
+		auto &busy_b = busy[pairs[i].b];
+
+		size_t round = 0;
+		while ((round < busy_a.size() && busy_a[round]) ||
+			   (round < busy_b.size() && busy_b[round]))
+		{
+			round += 1;
+		}
+		for (auto *solid : {&busy_a, &busy_b})
+		{
+			if (solid->size() <= round)
+			{
+				solid->resize(round + 1, false);
+			}
+			(*solid)[round] = true;
+		}
+		rounds[i] = round;
+	}
+	return rounds;
+}
+
+std::vector<overlap_fix> resolve_solid_overlaps(
+	document &doc, const std::vector<overlap_pair> &pairs, unsigned pave_time_millisecs,
+	pair_cache *cache,
+	const std::vector<imprint_result> *imprints)
+{
+	const bool use_cache = cache && cache->enabled();
+
+	// and their indices in pairs
+	std::vector<overlap_pair> overlapping;
+	std::vector<size_t> indices;
+	for (size_t i = 0; i < pairs.size(); i++)
+	{
+		if (pairs[i].status == intersect_status::overlap)
+		{
+			overlapping.push_back(pairs[i]);
+			indices.push_back(i);
+		}
+	}
+
+	// solids modified by an earlier round, whose imprints from classifying
+	// are out of date. not vector<bool>, as pairs in a round write to it
+	// concurrently
+	std::vector<char> changed(doc.solid_shapes.size(), 0);
+
+	const auto rounds = schedule_overlap_rounds(overlapping);
+	const size_t num_rounds = rounds.empty() ? 0 : *std::max_element(rounds.begin(), rounds.end()) + 1;
+
+	spdlog::info("resolving {} overlapping pairs in {} rounds", overlapping.size(), num_rounds);
+
+	std::vector<overlap_fix> fixes(overlapping.size());
+	for (size_t round = 0; round < num_rounds; round++)
+	{
+		std::vector<size_t> members;
+		for (size_t i = 0; i < overlapping.size(); i++)
+		{
+			if (rounds[i] == round)
+			{
+				members.push_back(i);
+			}
+		}
+
+		// no solid appears twice in a round, so the pairs can update the
+		// document without conflicting. imprinting only ever removes volume,
+		// so resolving a pair never makes another overlap
+		OSD_Parallel::For(0, (int)members.size(), [&](int j)
+		{
+			const size_t i = members[j];
+			const auto &pair = overlapping[i];
+			overlap_fix &fix = fixes[i];
+			fix.a = pair.a;
+			fix.b = pair.b;
+			fix.round = round;
+			// with the fuzzy value the pair was classified with, a retry's when
+			// the requested one failed, as its imprint from classifying was
+			const double pair_fuzzy_value = pair.fuzzy_value;
+			fix.status = imprint_status::failed;
+			fix.fuzzy_value = pair_fuzzy_value;
+			fix.vol_common = -1;
+			fix.cached = false;
+
+			imprint_result result{};
+			const imprint_result *classified = imprints ? &(*imprints)[indices[i]] : nullptr;
+			if (classified && classified->status != imprint_status::failed &&
+				!changed[pair.a] && !changed[pair.b])
+			{
+				result = *classified;
+			}
+			else
+			{
+				// solids change between rounds, so are fingerprinted as they
+				// are now
+				uint64_t fingerprint_a = 0, fingerprint_b = 0;
+				if (use_cache)
+				{
+					fingerprint_a = shape_fingerprint(doc.solid_shapes[pair.a]);
+					fingerprint_b = shape_fingerprint(doc.solid_shapes[pair.b]);
+				}
+				fix.cached = use_cache && cache->lookup(fingerprint_a, fingerprint_b, pair_fuzzy_value, result);
+				if (!fix.cached)
+				{
+					try
+					{
+						result = perform_solid_imprinting(
+							doc.solid_shapes[pair.a], doc.solid_shapes[pair.b], pair_fuzzy_value, pave_time_millisecs);
+					}
+					catch (Standard_Failure &err)
+					{
+						spdlog::warn("imprinting solids {} and {} failed: {}", pair.a, pair.b, err.GetMessageString());
+						return;
+					}
+					catch (std::exception &err)
+					{
+						spdlog::warn("imprinting solids {} and {} failed: {}", pair.a, pair.b, err.what());
+						return;
+					}
+					// with a time limit a failure may be a timeout, which depends
+					// on the limit so isn't kept
+					if (use_cache && (result.status != imprint_status::failed || !pave_time_millisecs))
+					{
+						cache->store(fingerprint_a, fingerprint_b, pair_fuzzy_value, result);
+					}
+				}
+			}
+
+			fix.status = result.status;
+			fix.fuzzy_value = result.fuzzy_value;
+			fix.vol_common = result.vol_common;
+			if (result.status == imprint_status::merge_into_shape ||
+				result.status == imprint_status::merge_into_tool)
+			{
+				doc.solid_shapes[pair.a] = result.shape;
+				doc.solid_shapes[pair.b] = result.tool;
+				changed[pair.a] = changed[pair.b] = 1;
+			}
+		});
+	}
+
+	return fixes;
+}
+
+std::vector<overlap_fix> occ_overlap_fixer(
+	std::string input_brep_file,
+	std::string output_brep_file,
+	double fuzzy_value,
+	double pave_time_limit_secs,
+	std::string cache_directory,
+	bool logging)
+{
+	if (logging)
+	{
+		spdlog::set_level(spdlog::level::debug);
+	}
+	else
+	{
+		spdlog::set_level(spdlog::level::err);
+	}
+
+	spdlog::info("");
+	spdlog::info("Starting occ_overlap_fixer:");
+	spdlog::info("  input_brep_file: {}", input_brep_file);
+	spdlog::info("  output_brep_file: {}", output_brep_file);
+	spdlog::info("  fuzzy_value: {}", fuzzy_value);
+	spdlog::info("  pave_time_limit_secs: {}", pave_time_limit_secs);
+	spdlog::info("  cache_directory: {}", cache_directory);
+	spdlog::info("");
+
+	if (pave_time_limit_secs < 0)
+	{
+		spdlog::error("pave time limit ({}) should not be negative", pave_time_limit_secs);
+		std::exit(1);
+	}
+
+	document inp;
+	inp.load_brep_file(input_brep_file.c_str());
+
+	spdlog::info("Brep loaded");
+
+	// overlapping pairs are imprinted as they're classified, so those
+	// resolved in the first round don't need another pave filler
+	pair_cache cache{cache_directory};
+	std::vector<imprint_result> imprints;
+	const unsigned pave_time_millisecs = millisecs_to_unsigned(pave_time_limit_secs * 1000);
+	const auto pairs = check_solid_overlaps(inp, fuzzy_value, pave_time_millisecs, {}, &cache, &imprints);
+	const auto fixes = resolve_solid_overlaps(inp, pairs, pave_time_millisecs, &cache, &imprints);
+	if (cache.enabled())
+	{
+		spdlog::info("{} cached results reused, {} computed", cache.hits(), cache.misses());
+		cache.save();
+	}
+
+	size_t num_unresolved = 0;
+	for (const auto &pair : pairs)
+	{
+		if (pair.status == intersect_status::failed || pair.status == intersect_status::timeout)
+		{
+			num_unresolved += 1;
+		}
+	}
+	for (const auto &fix : fixes)
+	{
+		if (fix.status == imprint_status::failed)
+		{
+			num_unresolved += 1;
+		}
+	}
+	if (num_unresolved)
+	{
+		spdlog::warn("{} pairs could not be classified or resolved, and may still overlap", num_unresolved);
+	}
+
+	inp.write_brep_file(output_brep_file.c_str());
+
+	spdlog::info("Brep written");
+
+	return fixes;
+}
+
+#ifdef INCLUDE_TESTS
+#include <thread>
+
+// stands in for classifying a pair, failing at the listed fuzzy values and
+// touching at the others
+static auto
+attempt_failing_at(std::vector<double> failing)
+{
+	return [failing](double fuzzy_value, unsigned, const std::atomic<bool> *)
+	{
+		classify_imprint_result result{};
+		result.intersect.fuzzy_value = fuzzy_value;
+		const bool fails = std::find(failing.begin(), failing.end(), fuzzy_value) != failing.end();
+		result.intersect.status = fails ? intersect_status::failed : intersect_status::touching;
+		return result;
+	};
+}
+
+TEST_CASE("classify_with_retries")
+{
+	overlap_retry_policy retry;
+	retry.fuzzy_values = {0.01, 0.0001};
+
+	for (const bool concurrent : {false, true})
+	{
+		INFO("concurrent " << concurrent);
+		retry.concurrent = concurrent;
+		size_t attempts = 0;
+
+		// consistent at once
+		auto res = classify_with_retries(attempt_failing_at({}), 0.001, 0, retry, attempts);
+		CHECK(attempts == 1);
+		CHECK(res.intersect.fuzzy_value == 0.001);
+
+		// the first retry that succeeds is kept
+		res = classify_with_retries(attempt_failing_at({0.001}), 0.001, 0, retry, attempts);
+		CHECK(attempts >= 2);
+		CHECK(res.intersect.status == intersect_status::touching);
+		CHECK(res.intersect.fuzzy_value == 0.01);
+
+		res = classify_with_retries(attempt_failing_at({0.001, 0.01}), 0.001, 0, retry, attempts);
+		CHECK(attempts == 3);
+		CHECK(res.intersect.fuzzy_value == 0.0001);
+
+		// when nothing succeeds the first attempt stands
+		res = classify_with_retries(attempt_failing_at({0.001, 0.01, 0.0001}), 0.001, 0, retry, attempts);
+		CHECK(attempts == 3);
+		CHECK(res.intersect.status == intersect_status::failed);
+		CHECK(res.intersect.fuzzy_value == 0.001);
+	}
+
+	SECTION("an overlap with no common volume is retried")
+	{
+		const auto attempt = [](double fuzzy_value, unsigned, const std::atomic<bool> *)
+		{
+			classify_imprint_result result{};
+			result.intersect.fuzzy_value = fuzzy_value;
+			result.intersect.status = intersect_status::overlap;
+			result.intersect.vol_common = fuzzy_value == 0.001 ? 0 : 1;
+			return result;
+		};
+		size_t attempts = 0;
+		const auto res = classify_with_retries(attempt, 0.001, 0, retry, attempts);
+		CHECK(attempts == 2);
+		CHECK(res.intersect.fuzzy_value == 0.01);
+	}
+
+	SECTION("concurrent retries after one that succeeds are abandoned")
+	{
+		retry.concurrent = true;
+
+		// the last retry only finishes once abandoned, or gives up after a
+		// while when it never is
+		std::atomic<bool> was_abandoned{false};
+		const auto attempt = [&](double fuzzy_value, unsigned, const std::atomic<bool> *abandoned)
+		{
+			classify_imprint_result result{};
+			result.intersect.fuzzy_value = fuzzy_value;
+			result.intersect.status = fuzzy_value == 0.01 ? intersect_status::touching : intersect_status::failed;
+			if (fuzzy_value == 0.0001)
+			{
+				const auto give_up = std::chrono::steady_clock::now() + std::chrono::seconds{10};
+				while (!*abandoned && std::chrono::steady_clock::now() < give_up)
+				{
+					std::this_thread::yield();
+				}
+				was_abandoned = *abandoned;
+			}
+			return result;
+		};
+
+		size_t attempts = 0;
+		const auto res = classify_with_retries(attempt, 0.001, 0, retry, attempts);
+		CHECK(res.intersect.fuzzy_value == 0.01);
+		// skipped, or started and then abandoned
+		CHECK((attempts == 2 || was_abandoned));
+	}
+}
+
+static overlap_pair
+overlapping_pair(size_t a, size_t b)
+{
+	overlap_pair pair{};
+	pair.a = a;
+	pair.b = b;
+	pair.status = intersect_status::overlap;
+	return pair;
+}
+
+TEST_CASE("schedule_overlap_rounds")
+{
+	// a chain, and a pair apart from it
+	const std::vector<overlap_pair> pairs{
+		overlapping_pair(0, 1),
+		overlapping_pair(1, 2),
+		overlapping_pair(2, 3),
+		overlapping_pair(4, 5),
+	};
+
+	const auto rounds = schedule_overlap_rounds(pairs);
+	REQUIRE(rounds.size() == pairs.size());
+	CHECK(rounds == std::vector<size_t>{0, 1, 0, 0});
+
+	// no solid twice in a round
+	for (size_t i = 0; i < pairs.size(); i++)
+	{
+		for (size_t j = i + 1; j < pairs.size(); j++)
+		{
+			if (rounds[i] == rounds[j])
+			{
+				CHECK(pairs[i].a != pairs[j].a);
+				CHECK(pairs[i].a != pairs[j].b);
+				CHECK(pairs[i].b != pairs[j].a);
+				CHECK(pairs[i].b != pairs[j].b);
+			}
+		}
+	}
+}
+
+TEST_CASE("resolve_solid_overlaps")
+{
+	using Catch::Approx;
+
+	// a chain of cubes, each overlapping the next by a quarter
+	document doc;
+	for (int i = 0; i < 3; i++)
+	{
+		doc.solid_shapes.push_back(cube_at(i * 3, 0, 0, 4));
+	}
+	const double total = (2 * 3 + 4) * 4 * 4;
+
+	const auto pairs = check_solid_overlaps(doc, 0.01, 0);
+	size_t num_overlapping = 0;
+	for (const auto &pair : pairs)
+	{
+		if (pair.status == intersect_status::overlap)
+		{
+			CHECK(pair.vol_common == Approx(4 * 4));
+			num_overlapping += 1;
+		}
+	}
+	REQUIRE(num_overlapping == 2);
+
+	const auto fixes = resolve_solid_overlaps(doc, pairs, 0);
+	REQUIRE(fixes.size() == 2);
+	// the middle cube is in both, so they're resolved one after the other
+	CHECK(fixes[0].round != fixes[1].round);
+	for (const auto &fix : fixes)
+	{
+		CHECK(fix.status != imprint_status::failed);
+	}
+
+	double volume = 0;
+	for (const auto &solid : doc.solid_shapes)
+	{
+		volume += volume_of_shape(solid);
+	}
+
+	// the common volume went to one side, so is counted once
+	CHECK(volume == Approx(total));
+	for (const auto &pair : check_solid_overlaps(doc, 0.01, 0))
+	{
+		CHECK(pair.status != intersect_status::overlap);
+	}
+}
+
+#endif
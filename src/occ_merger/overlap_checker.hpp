@@ -0,0 +1,130 @@
+#ifndef OVERLAP_CHECKER_HPP
+#define OVERLAP_CHECKER_HPP
+
+#include <string>
+#include <vector>
+
+#include "geometry.hpp"
+#include "pair_cache.hpp"
+
+// classification of a pair of solids whose (fuzzy value inflated) bounding
+// boxes overlap. solids whose boxes don't overlap are distinct, so aren't
+// listed
+struct overlap_pair
+{
+	// indices into the document's solids, a < b
+	size_t a, b;
+
+	intersect_status status;
+	// the fuzzy value actually used, see intersect_result. after retries it
+	// is the one that succeeded
+	double fuzzy_value;
+	// number of classifications run, more than one when retried
+	size_t attempts;
+	// whether the result kept was found in the cache
+	bool cached;
+
+	// only valid if status == overlap
+	double vol_common, vol_cut, vol_cut12;
+
+	// time spent in the pave filler, and classifying the pair overall
+	double pave_seconds, seconds;
+};
+
+// how pairs that fail or time out are classified again. OCCT's failures
+// often go away with a different fuzzy value
+struct overlap_retry_policy
+{
+	// fuzzy values to try after the first, in order of preference
+	std::vector<double> fuzzy_values;
+
+	// each retry's pave time limit is the previous one's times this
+	double timeout_factor = 2;
+
+	// try all the fuzzy values at once, keeping the first in order that
+	// succeeds, rather than one at a time. once one does, those after it
+	// are abandoned
+	bool concurrent = false;
+};
+
+// classify every pair of solids whose bounding boxes overlap, concurrently.
+// pairs are found with a bounding volume hierarchy over the solids, and each
+// gets the pave time limit (zero for none). returned in order of (a, b). when
+// a cache is given, results in it are reused and new ones added. when imprints
+// is given, overlapping pairs are imprinted with the same pave filler they're
+// classified with, see classify_and_imprint_solids, and listed there in the
+// same order as the pairs. other entries are failed
+std::vector<overlap_pair> check_solid_overlaps(
+	const document &doc, double fuzzy_value, unsigned pave_time_millisecs,
+	const overlap_retry_policy &retry = {},
+	pair_cache *cache = nullptr,
+	std::vector<imprint_result> *imprints = nullptr);
+
+// Load a BREP file and classify the pairs of its solids that could touch or overlap.
+// Solids are numbered in file order. A pave time limit of zero disables it. Pairs that fail or
+// time out are retried with each of retry_fuzzy_values, concurrently if asked, with the time
+// limit growing by retry_timeout_factor each time. Results are kept in cache_directory, when not
+// empty, so pairs unchanged since the last run aren't intersected again
+std::vector<overlap_pair> occ_overlap_checker(
+	std::string input_brep_file,
+	double fuzzy_value,
+	double pave_time_limit_secs,
+	std::vector<double> retry_fuzzy_values,
+	double retry_timeout_factor,
+	bool concurrent_retries,
+	std::string cache_directory,
+	bool logging);
+
+// how one overlapping pair was resolved
+struct overlap_fix
+{
+	// indices into the document's solids, a < b
+	size_t a, b;
+
+	// which side the common volume went to, see perform_solid_imprinting.
+	// distinct when an earlier round already removed the overlap
+	imprint_status status;
+	// the fuzzy value the pair was imprinted with, the one its
+	// classification used, so a retry's when it needed one
+	double fuzzy_value;
+	double vol_common;
+
+	// pairs in the same round share no solid, so were imprinted concurrently
+	size_t round;
+
+	// whether the imprint was found in the cache
+	bool cached;
+};
+
+// group pairs into rounds so no solid appears twice in a round, by greedily
+// giving each pair, in order, the first round both its solids are free in.
+// returns the round of each pair
+std::vector<size_t> schedule_overlap_rounds(const std::vector<overlap_pair> &pairs);
+
+// resolve the overlapping pairs by merging each pair's common volume into one
+// side, a round at a time with the pairs of each round imprinted concurrently.
+// each pair is imprinted with the fuzzy value it was classified with. the
+// document's solids are updated in place. pairs that aren't overlapping
+// are skipped, and pairs whose imprinting fails or takes longer than the pave
+// time limit (zero for none) are left as they were. when a cache is given,
+// results in it are reused and new ones added. imprints from
+// check_solid_overlaps are reused for pairs neither of whose solids an
+// earlier round changed
+std::vector<overlap_fix> resolve_solid_overlaps(
+	document &doc, const std::vector<overlap_pair> &pairs, unsigned pave_time_millisecs,
+	pair_cache *cache = nullptr,
+	const std::vector<imprint_result> *imprints = nullptr);
+
+// Load a BREP file, find the pairs of its solids that overlap and resolve them, writing an
+// overlap-free BREP file ready for occ_merger. The pave time limit applies both to classifying and
+// to imprinting each pair, and pairs that failed or timed out at either are left as they were.
+// Results are kept in cache_directory as for occ_overlap_checker
+std::vector<overlap_fix> occ_overlap_fixer(
+	std::string input_brep_file,
+	std::string output_brep_file,
+	double fuzzy_value,
+	double pave_time_limit_secs,
+	std::string cache_directory,
+	bool logging);
+
+#endif // OVERLAP_CHECKER_HPP
@@ -0,0 +1,426 @@
+#include <algorithm>
+#include <array>
+#include <cinttypes>
+#include <cmath>
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <sstream>
+#include <utility>
+#include <vector>
+
+#include <spdlog/spdlog.h>
+
+#include <BRep_Builder.hxx>
+#include <BRep_Tool.hxx>
+#include <BRepTools.hxx>
+#include <TopExp.hxx>
+#include <TopoDS.hxx>
+#include <TopoDS_Compound.hxx>
+#include <TopoDS_Iterator.hxx>
+#include <TopTools_IndexedMapOfShape.hxx>
+
+#include "pair_cache.hpp"
+
+namespace
+{
+	// vertices are rounded to multiples of this, and volumes to multiples of
+	// the next
+	constexpr double fingerprint_grid = 1e-6;
+	constexpr double fingerprint_volume_grid = 1e-3;
+
+	// name of the file listing the results in the cache directory
+	constexpr const char *index_name = "pairs.txt";
+
+	// FNV-1a
+	class hasher
+	{
+		uint64_t hash_ = 14695981039346656037ull;
+
+	public:
+		void add(int64_t value)
+		{
+			for (int i = 0; i < 8; i++)
+			{
+				hash_ ^= (uint64_t)(value >> (i * 8)) & 0xff;
+				hash_ *= 1099511628211ull;
+			}
+		}
+
+		uint64_t value() const
+		{
+			return hash_;
+		}
+	};
+
+	std::string
+	make_key(uint64_t shape, uint64_t tool, double fuzzy_value)
+	{
+		char key[64];
+		std::snprintf(key, sizeof(key), "%016" PRIx64 "-%016" PRIx64 "-%.17g", shape, tool, fuzzy_value);
+		return key;
+	}
+
+	imprint_status
+	swap_sides(imprint_status status)
+	{
+		switch (status)
+		{
+		case imprint_status::merge_into_shape:
+			return imprint_status::merge_into_tool;
+		case imprint_status::merge_into_tool:
+			return imprint_status::merge_into_shape;
+		default:
+			return status;
+		}
+	}
+}
+
+uint64_t shape_fingerprint(const TopoDS_Shape &shape)
+{
+	TopTools_IndexedMapOfShape vertices, edges, faces;
+	TopExp::MapShapes(shape, TopAbs_VERTEX, vertices);
+	TopExp::MapShapes(shape, TopAbs_EDGE, edges);
+	TopExp::MapShapes(shape, TopAbs_FACE, faces);
+
+	// sorted, so the order vertices are stored in doesn't matter
+	std::vector<std::array<int64_t, 3>> points;
+	points.reserve((size_t)vertices.Extent());
+	for (int i = 1; i <= vertices.Extent(); i++)
+	{
+		const gp_Pnt pnt = BRep_Tool::Pnt(TopoDS::Vertex(vertices(i)));
+		points.push_back({
+			std::llround(pnt.X() / fingerprint_grid),
+			std::llround(pnt.Y() / fingerprint_grid),
+			std::llround(pnt.Z() / fingerprint_grid),
+		});
+	}
+	std::sort(points.begin(), points.end());
+
+	hasher hash;
+	hash.add((int64_t)shape.ShapeType());
+	hash.add(faces.Extent());
+	hash.add(edges.Extent());
+	hash.add(std::llround(volume_of_shape(shape) / fingerprint_volume_grid));
+	for (const auto &pnt : points)
+	{
+		hash.add(pnt[0]);
+		hash.add(pnt[1]);
+		hash.add(pnt[2]);
+	}
+	return hash.value();
+}
+
+pair_cache::pair_cache(std::string directory) : directory_{std::move(directory)}, dirty_{false}, hits_{0}, misses_{0}
+{
+	if (!enabled())
+	{
+		return;
+	}
+
+	std::ifstream index{std::filesystem::path{directory_} / index_name};
+	if (!index)
+	{
+		spdlog::debug("no cached results in {}", directory_);
+		return;
+	}
+
+	std::string line;
+	while (std::getline(index, line))
+	{
+		std::istringstream fields{line};
+		std::string kind, key;
+		entry ent;
+		fields >> kind >> key >> ent.status >> ent.fuzzy_value
+			>> ent.num_warnings[0] >> ent.num_warnings[1] >> ent.num_warnings[2]
+			>> ent.vol_common >> ent.vol_cut >> ent.vol_cut12 >> ent.pave_time_seconds;
+		if (!fields)
+		{
+			spdlog::warn("ignoring malformed cache entry: {}", line);
+			continue;
+		}
+		if (kind == "intersect")
+		{
+			intersects_[key] = ent;
+		}
+		else if (kind == "imprint")
+		{
+			imprints_[key] = ent;
+		}
+	}
+
+	spdlog::debug(
+		"loaded {} intersect and {} imprint results from {}",
+		intersects_.size(), imprints_.size(), directory_);
+}
+
+std::string pair_cache::shapes_path(const std::string &key) const
+{
+	return (std::filesystem::path{directory_} / (key + ".brep")).string();
+}
+
+bool pair_cache::lookup(uint64_t shape, uint64_t tool, double fuzzy_value, intersect_result &result) const
+{
+	if (!enabled())
+	{
+		return false;
+	}
+
+	entry ent;
+	bool swapped = false;
+	{
+		std::lock_guard<std::mutex> lock{mutex_};
+		auto it = intersects_.find(make_key(shape, tool, fuzzy_value));
+		if (it == intersects_.end())
+		{
+			it = intersects_.find(make_key(tool, shape, fuzzy_value));
+			swapped = true;
+		}
+		if (it == intersects_.end())
+		{
+			misses_ += 1;
+			return false;
+		}
+		ent = it->second;
+		used_.insert(it->first);
+	}
+
+	result.status = (intersect_status)ent.status;
+	result.fuzzy_value = ent.fuzzy_value;
+	result.num_filler_warnings = ent.num_warnings[0];
+	result.num_common_warnings = ent.num_warnings[1];
+	result.num_section_warnings = ent.num_warnings[2];
+	result.vol_common = ent.vol_common;
+	result.vol_cut = swapped ? ent.vol_cut12 : ent.vol_cut;
+	result.vol_cut12 = swapped ? ent.vol_cut : ent.vol_cut12;
+	result.pave_time_seconds = ent.pave_time_seconds;
+	hits_ += 1;
+	return true;
+}
+
+void pair_cache::store(uint64_t shape, uint64_t tool, double fuzzy_value, const intersect_result &result)
+{
+	if (!enabled() || result.status == intersect_status::timeout)
+	{
+		return;
+	}
+
+	const entry ent{
+		(int)result.status,
+		result.fuzzy_value,
+		{result.num_filler_warnings, result.num_common_warnings, result.num_section_warnings},
+		result.vol_common,
+		result.vol_cut,
+		result.vol_cut12,
+		result.pave_time_seconds,
+	};
+
+	const std::string key = make_key(shape, tool, fuzzy_value);
+	std::lock_guard<std::mutex> lock{mutex_};
+	intersects_[key] = ent;
+	used_.insert(key);
+	dirty_ = true;
+}
+
+bool pair_cache::lookup(uint64_t shape, uint64_t tool, double fuzzy_value, imprint_result &result) const
+{
+	if (!enabled())
+	{
+		return false;
+	}
+
+	std::string key = make_key(shape, tool, fuzzy_value);
+	entry ent;
+	bool swapped = false;
+	{
+		std::lock_guard<std::mutex> lock{mutex_};
+		auto it = imprints_.find(key);
+		if (it == imprints_.end())
+		{
+			key = make_key(tool, shape, fuzzy_value);
+			it = imprints_.find(key);
+			swapped = true;
+		}
+		if (it == imprints_.end())
+		{
+			misses_ += 1;
+			return false;
+		}
+		ent = it->second;
+		used_.insert(key);
+	}
+
+	TopoDS_Shape shapes[2];
+	if ((imprint_status)ent.status != imprint_status::failed)
+	{
+		// the resulting solids are kept beside the index, as a compound of
+		// the shape and the tool
+		BRep_Builder builder;
+		TopoDS_Shape compound;
+		if (!BRepTools::Read(compound, shapes_path(key).c_str(), builder) || compound.NbChildren() != 2)
+		{
+			spdlog::warn("cached imprint result {} is missing its shapes", key);
+			misses_ += 1;
+			return false;
+		}
+		TopoDS_Iterator it{compound};
+		shapes[0] = it.Value();
+		it.Next();
+		shapes[1] = it.Value();
+	}
+
+	result.status = swapped ? swap_sides((imprint_status)ent.status) : (imprint_status)ent.status;
+	result.fuzzy_value = ent.fuzzy_value;
+	result.num_filler_warnings = ent.num_warnings[0];
+	result.num_common_warnings = ent.num_warnings[1];
+	result.num_fuse_warnings = ent.num_warnings[2];
+	result.vol_common = ent.vol_common;
+	result.vol_cut = swapped ? ent.vol_cut12 : ent.vol_cut;
+	result.vol_cut12 = swapped ? ent.vol_cut : ent.vol_cut12;
+	result.shape = shapes[swapped ? 1 : 0];
+	result.tool = shapes[swapped ? 0 : 1];
+	hits_ += 1;
+	return true;
+}
+
+void pair_cache::store(uint64_t shape, uint64_t tool, double fuzzy_value, const imprint_result &result)
+{
+	if (!enabled())
+	{
+		return;
+	}
+
+	const std::string key = make_key(shape, tool, fuzzy_value);
+	if (result.status != imprint_status::failed)
+	{
+		std::error_code err;
+		std::filesystem::create_directories(directory_, err);
+
+		TopoDS_Compound compound;
+		BRep_Builder builder;
+		builder.MakeCompound(compound);
+		builder.Add(compound, result.shape);
+		builder.Add(compound, result.tool);
+		if (err || !BRepTools::Write(compound, shapes_path(key).c_str()))
+		{
+			// only costs the result being computed again next time
+			spdlog::warn("failed to cache imprint result {} in {}", key, directory_);
+			return;
+		}
+	}
+
+	const entry ent{
+		(int)result.status,
+		result.fuzzy_value,
+		{result.num_filler_warnings, result.num_common_warnings, result.num_fuse_warnings},
+		result.vol_common,
+		result.vol_cut,
+		result.vol_cut12,
+		-1,
+	};
+
+	std::lock_guard<std::mutex> lock{mutex_};
+	imprints_[key] = ent;
+	used_.insert(key);
+	dirty_ = true;
+}
+
+void pair_cache::save()
+{
+	std::lock_guard<std::mutex> lock{mutex_};
+	if (!enabled())
+	{
+		return;
+	}
+
+	// results of pairs not seen this run, e.g. of solids since changed or
+	// removed, are dropped so the cache doesn't grow without bound
+	size_t num_unused = 0;
+	for (auto *entries : {&intersects_, &imprints_})
+	{
+		for (auto it = entries->begin(); it != entries->end();)
+		{
+			if (used_.count(it->first))
+			{
+				++it;
+			}
+			else
+			{
+				it = entries->erase(it);
+				num_unused += 1;
+			}
+		}
+	}
+	if (!dirty_ && !num_unused)
+	{
+		return;
+	}
+
+	// a cache that can't be written only costs the results being computed
+	// again next time
+	std::error_code err;
+	std::filesystem::create_directories(directory_, err);
+	if (err)
+	{
+		spdlog::warn("failed to create cache directory {}: {}", directory_, err.message());
+		return;
+	}
+
+	// written alongside then renamed, so an interrupted save leaves the
+	// previous index intact
+	const auto path = std::filesystem::path{directory_} / index_name;
+	auto tmp_path = path;
+	tmp_path += ".tmp";
+	{
+		std::ofstream index{tmp_path};
+		index.precision(17);
+		const std::pair<const char *, const std::unordered_map<std::string, entry> &> kinds[] = {
+			{"intersect", intersects_},
+			{"imprint", imprints_},
+		};
+		for (const auto &[kind, entries] : kinds)
+		{
+			for (const auto &[key, ent] : entries)
+			{
+				index << kind << ' ' << key << ' ' << ent.status << ' ' << ent.fuzzy_value << ' '
+					  << ent.num_warnings[0] << ' ' << ent.num_warnings[1] << ' ' << ent.num_warnings[2] << ' '
+					  << ent.vol_common << ' ' << ent.vol_cut << ' ' << ent.vol_cut12 << ' '
+					  << ent.pave_time_seconds << '\n';
+			}
+		}
+		if (!index)
+		{
+			spdlog::warn("failed to write cache index {}", tmp_path.string());
+			return;
+		}
+	}
+	std::filesystem::rename(tmp_path, path, err);
+	if (err)
+	{
+		spdlog::warn("failed to write cache index {}: {}", path.string(), err.message());
+		return;
+	}
+	dirty_ = false;
+
+	// shapes no longer listed, e.g. of an imprint stored again as failed,
+	// are removed
+	size_t num_pruned = 0;
+	for (std::filesystem::directory_iterator it{directory_, err}, end; !err && it != end; it.increment(err))
+	{
+		const auto &file = it->path();
+		if (file.extension() != ".brep")
+		{
+			continue;
+		}
+		const auto found = imprints_.find(file.stem().string());
+		if (found == imprints_.end() || (imprint_status)found->second.status == imprint_status::failed)
+		{
+			std::error_code remove_err;
+			num_pruned += std::filesystem::remove(file, remove_err) ? 1 : 0;
+		}
+	}
+	if (num_pruned)
+	{
+		spdlog::debug("pruned {} cached shapes from {}", num_pruned, directory_);
+	}
+}
@@ -0,0 +1,80 @@
+#ifndef PAIR_CACHE_HPP
+#define PAIR_CACHE_HPP
+
+#include <atomic>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+
+#include "geometry.hpp"
+
+// fingerprint of a solid's geometry: its type, numbers of faces and edges,
+// volume, and vertices rounded to a fixed grid. equal for solids that are the
+// same up to rounding, whatever order their sub-shapes are in
+uint64_t shape_fingerprint(const TopoDS_Shape &shape);
+
+// results of classifying and imprinting pairs of solids, kept in a directory
+// between runs so pairs that haven't changed aren't intersected again. keyed
+// on the fingerprints of both solids and the fuzzy value asked for. a result
+// stored for (a, b) is also found, swapped, for (b, a). timeouts depend on the
+// time limit so aren't kept. only results looked up or stored during a run
+// are saved, so the cache holds no more than the pairs of the last model
+// checked. may be shared between threads
+class pair_cache
+{
+	struct entry
+	{
+		int status;
+		double fuzzy_value;
+		int num_warnings[3];
+		double vol_common, vol_cut, vol_cut12;
+		double pave_time_seconds;
+	};
+
+	std::string directory_;
+	mutable std::mutex mutex_;
+	std::unordered_map<std::string, entry> intersects_, imprints_;
+	// keys of results looked up or stored since loading
+	mutable std::unordered_set<std::string> used_;
+	bool dirty_;
+
+	mutable std::atomic<size_t> hits_, misses_;
+
+	std::string shapes_path(const std::string &key) const;
+
+public:
+	// loads the cache held in directory, which is created when saved. an
+	// empty directory disables the cache
+	explicit pair_cache(std::string directory);
+
+	bool enabled() const
+	{
+		return !directory_.empty();
+	}
+
+	bool lookup(uint64_t shape, uint64_t tool, double fuzzy_value, intersect_result &result) const;
+	void store(uint64_t shape, uint64_t tool, double fuzzy_value, const intersect_result &result);
+
+	bool lookup(uint64_t shape, uint64_t tool, double fuzzy_value, imprint_result &result) const;
+	void store(uint64_t shape, uint64_t tool, double fuzzy_value, const imprint_result &result);
+
+	// write out the results used, when any were stored or any loaded went
+	// unused, and remove the shapes of imprints no longer listed. an imprint
+	// is kept while the intersection of its pair was used. a failure is
+	// warned about and leaves the saved index as it was
+	void save();
+
+	size_t hits() const
+	{
+		return hits_;
+	}
+
+	size_t misses() const
+	{
+		return misses_;
+	}
+};
+
+#endif // PAIR_CACHE_HPP
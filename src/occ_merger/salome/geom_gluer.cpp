@@ -24,9 +24,23 @@
 // See http://www.salome-platform.org/ or email : webmaster.salome@opencascade.com
 //
 
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstdlib>
 #include <exception>
+#include <memory>
 #include <stdexcept>
 #include <optional>
+#include <iterator>
+#include <numeric>
+#include <string>
+#include <tuple>
+#include <unordered_map>
+#include <vector>
 
 #include <Standard.hxx>
 #include <Standard_Macro.hxx>
@@ -36,13 +50,35 @@
 #include <gp_Pnt.hxx>
 #include <gp_Pnt2d.hxx>
 
+#include <BRepAdaptor_Curve.hxx>
+#include <BRepAdaptor_Surface.hxx>
 #include <BRepLib.hxx>
 #include <BRepTools.hxx>
+#include <ElCLib.hxx>
+#include <ElSLib.hxx>
+#include <gp_Circ.hxx>
+#include <gp_Cylinder.hxx>
+#include <gp_Lin.hxx>
+#include <gp_Pln.hxx>
 #include <BRep_Builder.hxx>
+#include <BRepBndLib.hxx>
+#include <Bnd_Box.hxx>
+
+#include <OSD_MemInfo.hxx>
+#include <OSD_Parallel.hxx>
+
+#include <BOPAlgo_Alerts.hxx>
+#include <BOPAlgo_Builder.hxx>
+#include <BRepTools_History.hxx>
+
+#include <Message_ProgressRange.hxx>
+#include <Message_ProgressScope.hxx>
 
 #include <NCollection_UBTree.hxx>
 #include <NCollection_UBTreeFiller.hxx>
 #include <NCollection_IndexedDataMap.hxx>
+#include <NCollection_DataMap.hxx>
+#include <NCollection_IncAllocator.hxx>
 
 #include <TColStd_ListOfInteger.hxx>
 #include <TColStd_MapOfInteger.hxx>
@@ -66,6 +102,7 @@
 #include <TopAbs_ShapeEnum.hxx>
 
 #include <TopTools_MapOfShape.hxx>
+#include <TopTools_ShapeMapHasher.hxx>
 #include <TopTools_ListOfShape.hxx>
 #include <TopTools_IndexedMapOfShape.hxx>
 #include <TopTools_DataMapOfShapeListOfShape.hxx>
@@ -133,6 +170,63 @@ namespace
 		}
 	}
 
+	// stops the gluer if a break (cancellation or time limit) has been
+	// requested through its progress indicator
+	void
+	check_for_break(const Message_ProgressScope &scope)
+	{
+		if (scope.UserBreak())
+		{
+			throw glue_cancelled{"gluing was cancelled"};
+		}
+	}
+
+	// resident memory of the process, and its high-water mark, zero when
+	// the platform doesn't report them
+	void
+	process_memory(size_t &working_set, size_t &peak)
+	{
+		OSD_MemInfo info{Standard_False};
+		info.SetActive(Standard_False);
+		info.SetActive(OSD_MemInfo::MemWorkingSet, Standard_True);
+		info.SetActive(OSD_MemInfo::MemWorkingSetPeak, Standard_True);
+		info.Update();
+
+		const auto value = [&](OSD_MemInfo::Counter counter) -> size_t
+		{
+			const Standard_Size bytes = info.Value(counter);
+			return bytes == Standard_Size(-1) ? 0 : (size_t)bytes;
+		};
+		working_set = value(OSD_MemInfo::MemWorkingSet);
+		peak = value(OSD_MemInfo::MemWorkingSetPeak);
+	}
+
+	// records the wall time of a phase, and memory use at its end
+	class phase_timer
+	{
+		using clock = std::chrono::steady_clock;
+
+		glue_stats *stats;
+		const char *name;
+		clock::time_point started;
+
+	public:
+		phase_timer(glue_stats *stats, const char *name)
+			: stats{stats}, name{name}, started{clock::now()} {}
+
+		~phase_timer()
+		{
+			if (stats)
+			{
+				size_t working_set, peak;
+				process_memory(working_set, peak);
+				stats->add_phase(
+					name, std::chrono::duration<double>(clock::now() - started).count(), working_set);
+				stats->peak_memory_bytes = std::max(stats->peak_memory_bytes, peak);
+			}
+		}
+	};
+
 	class BoundingSphere
 	{
 		gp_Pnt center;
@@ -193,15 +287,34 @@ namespace
 		filler.Fill();
 	}
 
+	// the smallest tolerance at which the gluer considers two vertices
+	// coincident, spheres are inflated by it, see BoundingSphere::IsOut
+	Standard_Real
+	vertex_pair_tolerance(const TopoDS_Vertex &a, const TopoDS_Vertex &b)
+	{
+		const Standard_Real gap =
+			BRep_Tool::Pnt(a).Distance(BRep_Tool::Pnt(b)) - BRep_Tool::Tolerance(a) - BRep_Tool::Tolerance(b);
+		return std::max(0.5 * gap, 0.);
+	}
+
 	class VertexSelector : public VertexTree::Selector
 	{
 		BoundingSphere sphere;
 		TColStd_MapOfInteger fence;
 		TColStd_ListOfInteger indicies;
+		// owning solid of each vertex (negative when not owned by one) and of
+		// this one, vertices of the same solid are skipped
+		const std::vector<int> *owners = nullptr;
+		int owner = -1;
 
 	public:
-		VertexSelector(const TopoDS_Vertex &vertex, Standard_Real tolerance)
-			: sphere{BRep_Tool::Pnt(vertex), BRep_Tool::Tolerance(vertex), tolerance} {}
+		// there are many short queries, so allow them to use an arena
+		VertexSelector(
+			const TopoDS_Vertex &vertex, Standard_Real tolerance,
+			const Handle(NCollection_BaseAllocator) &allocator = nullptr)
+			: sphere{BRep_Tool::Pnt(vertex), BRep_Tool::Tolerance(vertex), tolerance},
+			  fence{1, allocator},
+			  indicies{allocator} {}
 
 		bool Reject(const BoundingSphere &other) const override
 		{
@@ -210,6 +323,10 @@ namespace
 
 		bool Accept(const Standard_Integer &index) override
 		{
+			if (owner >= 0 && (*owners)[(size_t)index] == owner)
+			{
+				return false;
+			}
 			if (fence.Add(index))
 			{
 				indicies.Append(index);
@@ -218,78 +335,241 @@ namespace
 			return false;
 		}
 
+		void SkipOwner(const std::vector<int> &vertex_owners, int vertex_owner)
+		{
+			owners = &vertex_owners;
+			owner = vertex_owner;
+		}
+
 		const TColStd_ListOfInteger &Indices() const
 		{
 			return indicies;
 		}
 	};
 
+	// set of shapes, identified by their index in a TopTools_IndexedMapOfShape.
+	// indicies are kept sorted so equal sets compare element-wise, and the
+	// common case of a few vertices or edges is stored without allocating
 	class MultiShapeKey
 	{
-		TopTools_MapOfShape key;
-		// overflowing sum is defined for unsigned types
-		unsigned hashsum;
+		static constexpr size_t inline_size = 4;
+
+		size_t count;
+		std::array<Standard_Integer, inline_size> inline_ids;
+		// only used when there are more than inline_size indicies
+		std::vector<Standard_Integer> spilled_ids;
+
+		const Standard_Integer *data() const
+		{
+			return count > inline_size ? spilled_ids.data() : inline_ids.data();
+		}
+
+		static uint64_t mix(uint64_t x)
+		{
+			// splitmix64 finalizer
+			x ^= x >> 30;
+			x *= 0xbf58476d1ce4e5b9ULL;
+			x ^= x >> 27;
+			x *= 0x94d049bb133111ebULL;
+			x ^= x >> 31;
+			return x;
+		}
 
 	public:
-		using KeyIterator = TopTools_MapOfShape::Iterator;
+		MultiShapeKey() : count{0}, inline_ids{} {}
 
-		MultiShapeKey(const TopoDS_Shape &shape) : key{1}
+		explicit MultiShapeKey(Standard_Integer id) : MultiShapeKey{}
 		{
-			key.Add(shape);
-			hashsum += std::hash<TopoDS_Shape>{}(shape);
+			Add(id);
 		}
 
-		MultiShapeKey(const TopTools_ListOfShape &shapes) : key(shapes.Extent()), hashsum{0}
+		void Add(Standard_Integer id)
 		{
-			for (const auto &shape : shapes)
+			if (count < inline_size)
+			{
+				const auto first = inline_ids.begin(), last = first + count;
+				const auto pos = std::lower_bound(first, last, id);
+				if (pos != last && *pos == id)
+				{
+					return;
+				}
+				std::copy_backward(pos, last, last + 1);
+				*pos = id;
+			}
+			else
 			{
-				key.Add(shape);
-				hashsum += std::hash<TopoDS_Shape>{}(shape);
+				if (count == inline_size)
+				{
+					spilled_ids.assign(inline_ids.begin(), inline_ids.end());
+				}
+				const auto pos = std::lower_bound(spilled_ids.begin(), spilled_ids.end(), id);
+				if (pos != spilled_ids.end() && *pos == id)
+				{
+					return;
+				}
+				spilled_ids.insert(pos, id);
 			}
+			count += 1;
 		}
 
-		struct Hasher
+		size_t Hash() const
 		{
-
-			unsigned operator()(const MultiShapeKey &key) const noexcept
+			uint64_t hash = mix(count);
+			const Standard_Integer *ids = data();
+			for (size_t i = 0; i < count; i++)
 			{
-				return Hasher::HashCode(key);
+				hash = mix(hash ^ (0x9e3779b97f4a7c15ULL * (uint64_t)(uint32_t)ids[i]));
 			}
+			return (size_t)hash;
+		}
+
+		bool operator==(const MultiShapeKey &rhs) const
+		{
+			return count == rhs.count && std::equal(data(), data() + count, rhs.data());
+		}
 
-			unsigned operator()(const MultiShapeKey &key1, const MultiShapeKey &key2) const noexcept
+		struct Hasher
+		{
+			size_t operator()(const MultiShapeKey &key) const noexcept
 			{
-				return Hasher::IsEqual(key1, key2);
+				return key.Hash();
 			}
 
-			static Standard_Integer HashCode(
-				const MultiShapeKey &key, const Standard_Integer upper)
+			bool operator()(const MultiShapeKey &key1, const MultiShapeKey &key2) const noexcept
 			{
-				return std::hash<unsigned>{}(key.hashsum);
+				return key1 == key2;
 			}
+		};
+	};
+
+	using BoxTreeFiller = NCollection_UBTreeFiller<Standard_Integer, Bnd_Box>;
+	using BoxTree = BoxTreeFiller::UBTree;
+
+	class BoxSelector : public BoxTree::Selector
+	{
+		const Bnd_Box &box;
+		TColStd_ListOfInteger indicies;
+
+	public:
+		BoxSelector(const Bnd_Box &box) : box{box} {}
+
+		bool Reject(const Bnd_Box &other) const override
+		{
+			return box.IsOut(other);
+		}
+
+		bool Accept(const Standard_Integer &index) override
+		{
+			indicies.Append(index);
+			return true;
+		}
+
+		const TColStd_ListOfInteger &Indices() const
+		{
+			return indicies;
+		}
+	};
+
+	// box containing every point within tolerance of the shape. triangulation
+	// is ignored as it can cut inside curved geometry
+	Bnd_Box
+	inflated_bounding_box(const TopoDS_Shape &shape, Standard_Real tolerance)
+	{
+		Bnd_Box box;
+		BRepBndLib::Add(shape, box, Standard_False);
+		box.Enlarge(tolerance);
+		return box;
+	}
+
+	// the solid owning each vertex, edge and face of a shape, for the
+	// cross-solid mode. sub-shapes of one solid are already shared where they
+	// should be, so pairs of them are never glued, and a solid with no other
+	// solid within tolerance has nothing to glue at all
+	class solid_owners
+	{
+		NCollection_DataMap<TopoDS_Shape, int, TopTools_ShapeMapHasher> owners;
+		std::vector<bool> isolated;
+
+	public:
+		// sub-shapes of several solids, or of none, aren't owned
+		static constexpr int not_owned = -1;
 
-			static Standard_Integer HashCode(
-				const MultiShapeKey &key)
+		solid_owners(const TopoDS_Shape &shape, Standard_Real tolerance)
+		{
+			std::vector<TopoDS_Shape> solids;
+			for (TopExp_Explorer ex{shape, TopAbs_SOLID}; ex.More(); ex.Next())
 			{
-				return std::hash<unsigned>{}(key.hashsum);
+				solids.push_back(ex.Current());
 			}
 
-			static Standard_Boolean IsEqual(
-				const MultiShapeKey &lhs, const MultiShapeKey &rhs)
+			for (int i = 0; i < (int)solids.size(); i++)
 			{
-				if (lhs.key.Extent() != rhs.key.Extent())
+				TopTools_IndexedMapOfShape shapes;
+				TopExp::MapShapes(solids[(size_t)i], TopAbs_VERTEX, shapes);
+				TopExp::MapShapes(solids[(size_t)i], TopAbs_EDGE, shapes);
+				TopExp::MapShapes(solids[(size_t)i], TopAbs_FACE, shapes);
+				for (int j = 1; j <= shapes.Extent(); j++)
 				{
-					return false;
+					if (int *owner = owners.ChangeSeek(shapes(j)))
+					{
+						if (*owner != i)
+						{
+							*owner = not_owned;
+						}
+					}
+					else
+					{
+						owners.Bind(shapes(j), i);
+					}
 				}
-				for (KeyIterator it{lhs.key}; it.More(); it.Next())
+			}
+
+			std::vector<Bnd_Box> boxes;
+			boxes.reserve(solids.size());
+			BoxTree tree;
+			{
+				BoxTreeFiller filler(tree);
+				for (size_t i = 0; i < solids.size(); i++)
 				{
-					if (!rhs.key.Contains(it.Value()))
+					boxes.push_back(inflated_bounding_box(solids[i], tolerance));
+					if (!boxes.back().IsVoid())
 					{
-						return false;
+						filler.Add((Standard_Integer)i, boxes.back());
 					}
 				}
-				return true;
+				filler.Fill();
 			}
-		};
+
+			// a solid's box always overlaps itself
+			isolated.resize(solids.size(), true);
+			for (size_t i = 0; i < solids.size(); i++)
+			{
+				if (!boxes[i].IsVoid())
+				{
+					BoxSelector nearby{boxes[i]};
+					tree.Select(nearby);
+					isolated[i] = nearby.Indices().Extent() <= 1;
+				}
+			}
+		}
+
+		int Of(const TopoDS_Shape &shape) const
+		{
+			const int *owner = owners.Seek(shape);
+			return owner ? *owner : not_owned;
+		}
+
+		bool SameSolid(const TopoDS_Shape &shape, const TopoDS_Shape &other) const
+		{
+			const int owner = Of(shape);
+			return owner != not_owned && owner == Of(other);
+		}
+
+		bool Isolated(const TopoDS_Shape &shape) const
+		{
+			const int owner = Of(shape);
+			return owner != not_owned && isolated[(size_t)owner];
+		}
 	};
 
 	template <typename T>
@@ -335,26 +615,104 @@ namespace
 		}
 	}
 
-	class shape_merger
+	// closed form description of an edge's curve or a face's surface, for the
+	// elementary types most glued shapes have
+	struct analytic_geometry
 	{
-		IntTools_Context &ctx;
-		Standard_Real tolerance;
+		enum kind_t
+		{
+			free_form,
+			line,
+			circle,
+			plane,
+			cylinder
+		} kind = free_form;
+
+		gp_Lin lin;
+		gp_Circ circ;
+		gp_Pln pln;
+		gp_Cylinder cyl;
+
+		// parameter range of an edge, or the uv bounds of a face
+		Standard_Real u_min = 0, u_max = 0, v_min = 0, v_max = 0;
+	};
 
-		std::optional<gp_Pnt> ProjectPointOnShape(const gp_Pnt &point, const TopoDS_Shape &shape);
-		TopTools_ListOfShape FindNearby(const TopoDS_Shape &shape, const TopTools_ListOfShape &others);
-		TopTools_IndexedDataMapOfShapeListOfShape FindNearbyPairwise(const TopTools_ListOfShape &shapes);
+	analytic_geometry
+	describe_geometry(const TopoDS_Shape &shape)
+	{
+		analytic_geometry result;
+		if (shape.ShapeType() == TopAbs_EDGE)
+		{
+			const TopoDS_Edge &edge = TopoDS::Edge(shape);
+			if (BRep_Tool::Degenerated(edge) || !BRep_Tool::IsGeometric(edge))
+			{
+				return result;
+			}
+			BRepAdaptor_Curve curve{edge};
+			result.u_min = curve.FirstParameter();
+			result.u_max = curve.LastParameter();
+			switch (curve.GetType())
+			{
+			case GeomAbs_Line:
+				result.kind = analytic_geometry::line;
+				result.lin = curve.Line();
+				break;
+			case GeomAbs_Circle:
+				result.kind = analytic_geometry::circle;
+				result.circ = curve.Circle();
+				break;
+			default:
+				break;
+			}
+		}
+		else if (shape.ShapeType() == TopAbs_FACE)
+		{
+			const TopoDS_Face &face = TopoDS::Face(shape);
+			// the same bounds the projector is restricted to
+			BRepTools::UVBounds(face, result.u_min, result.u_max, result.v_min, result.v_max);
+			BRepAdaptor_Surface surface{face, Standard_False};
+			switch (surface.GetType())
+			{
+			case GeomAbs_Plane:
+				result.kind = analytic_geometry::plane;
+				result.pln = surface.Plane();
+				break;
+			case GeomAbs_Cylinder:
+				result.kind = analytic_geometry::cylinder;
+				result.cyl = surface.Cylinder();
+				break;
+			default:
+				break;
+			}
+		}
+		return result;
+	}
 
-	public:
-		typedef MultiShapeKeyedList<TopTools_ListOfShape> ShapeKeyedShapeList;
+	bool
+	in_range(Standard_Real u, Standard_Real min, Standard_Real max, Standard_Real slack)
+	{
+		return u >= min - slack && u <= max + slack;
+	}
 
-		shape_merger(IntTools_Context &context, Standard_Real tol) : ctx{context}, tolerance{tol} {}
+	// as in_range, for an angle
+	bool
+	in_angle_range(Standard_Real u, Standard_Real min, Standard_Real max, Standard_Real slack)
+	{
+		u = ElCLib::InPeriod(u, min - slack, min - slack + 2 * M_PI);
+		return u <= max + slack;
+	}
 
-		void RefineCoincidentShapes(ShapeKeyedShapeList &coincident_shapes);
-	};
+	// whether directions are parallel (either way) to within tolerance over
+	// the length
+	bool
+	parallel(const gp_Dir &a, const gp_Dir &b, Standard_Real length, Standard_Real tolerance)
+	{
+		return a.Crossed(b).Magnitude() * length < tolerance;
+	}
 
+	// the nearest point on an edge or face, restricted to its bounds
 	std::optional<gp_Pnt>
-	shape_merger::ProjectPointOnShape(
-		const gp_Pnt &point, const TopoDS_Shape &shape)
+	project_point_on_shape(IntTools_Context &ctx, const gp_Pnt &point, const TopoDS_Shape &shape)
 	{
 		switch (shape.ShapeType())
 		{
@@ -393,22 +751,215 @@ namespace
 		}
 	}
 
+	class shape_merger
+	{
+		IntTools_Context &ctx;
+		Standard_Real tolerance;
+		// shared with the detector so refined keys can't collide with pass keys
+		TopTools_IndexedMapOfShape &key_index;
+		glue_stats *stats;
+		// when non-null, shapes of the same solid are never coincident
+		const solid_owners *owners;
+
+		// cached tolerance inflated boxes, a point outside of these can't be
+		// coincident with the shape
+		NCollection_DataMap<TopoDS_Shape, Bnd_Box, TopTools_ShapeMapHasher> boxes;
+		NCollection_DataMap<TopoDS_Shape, analytic_geometry, TopTools_ShapeMapHasher> geometries;
+
+		// buckets at least this large are spatially indexed rather than
+		// checked pairwise
+		static constexpr size_t indexed_bucket_size = 32;
+
+		const Bnd_Box &BoundingBox(const TopoDS_Shape &shape);
+		const analytic_geometry &Geometry(const TopoDS_Shape &shape);
+		std::optional<bool> AnalyticNearby(const gp_Pnt &point, const TopoDS_Shape &shape, const TopoDS_Shape &other);
+		std::optional<gp_Pnt> ProjectPointOnShape(const gp_Pnt &point, const TopoDS_Shape &shape);
+		TopTools_ListOfShape FindNearby(size_t index, const std::vector<TopoDS_Shape> &others, const BoxTree *tree);
+		TopTools_IndexedDataMapOfShapeListOfShape FindNearbyPairwise(const TopTools_ListOfShape &shapes);
+
+	public:
+		typedef MultiShapeKeyedList<TopTools_ListOfShape> ShapeKeyedShapeList;
+
+		shape_merger(
+			IntTools_Context &context, Standard_Real tol,
+			TopTools_IndexedMapOfShape &index, glue_stats *stats,
+			const solid_owners *owners = nullptr)
+			: ctx{context}, tolerance{tol}, key_index{index}, stats{stats}, owners{owners} {}
+
+		void RefineCoincidentShapes(ShapeKeyedShapeList &coincident_shapes, const Message_ProgressRange &range);
+	};
+
+	const Bnd_Box &
+	shape_merger::BoundingBox(const TopoDS_Shape &shape)
+	{
+		if (const Bnd_Box *box = boxes.Seek(shape))
+		{
+			return *box;
+		}
+		return *boxes.Bound(shape, inflated_bounding_box(shape, tolerance));
+	}
+
+	const analytic_geometry &
+	shape_merger::Geometry(const TopoDS_Shape &shape)
+	{
+		if (const analytic_geometry *geometry = geometries.Seek(shape))
+		{
+			return *geometry;
+		}
+		return *geometries.Bound(shape, describe_geometry(shape));
+	}
+
+	// whether a point on shape is within tolerance of other, worked out in
+	// closed form when both are lines, circles, planes or cylinders lying on
+	// the same line (circle, ...) to within tolerance. empty when the point has
+	// to be projected instead, as for any other pair, so the result is the one
+	// projecting would give. as with the projection, the point must be within
+	// other's parameter range
+	std::optional<bool>
+	shape_merger::AnalyticNearby(
+		const gp_Pnt &point, const TopoDS_Shape &shape, const TopoDS_Shape &other)
+	{
+		const analytic_geometry &a = Geometry(shape);
+		const analytic_geometry &b = Geometry(other);
+		if (a.kind == analytic_geometry::free_form || a.kind != b.kind)
+		{
+			return {};
+		}
+
+		const auto checked = [&](bool nearby) -> std::optional<bool>
+		{
+			if (stats)
+			{
+				stats->num_analytic_checks += 1;
+			}
+			return nearby;
+		};
+
+		const Standard_Real tol2 = tolerance * tolerance;
+		switch (b.kind)
+		{
+		case analytic_geometry::line:
+		{
+			if (!parallel(a.lin.Direction(), b.lin.Direction(), a.u_max - a.u_min, tolerance))
+			{
+				return {};
+			}
+			const Standard_Real u = ElCLib::Parameter(b.lin, point);
+			return checked(in_range(u, b.u_min, b.u_max, tolerance) &&
+						   b.lin.SquareDistance(point) < tol2);
+		}
+		case analytic_geometry::circle:
+		{
+			const Standard_Real radius = b.circ.Radius();
+			if (std::abs(a.circ.Radius() - radius) >= tolerance ||
+				a.circ.Location().SquareDistance(b.circ.Location()) >= tol2 ||
+				!parallel(a.circ.Axis().Direction(), b.circ.Axis().Direction(), radius, tolerance))
+			{
+				return {};
+			}
+			const Standard_Real u = ElCLib::Parameter(b.circ, point);
+			return checked(in_angle_range(u, b.u_min, b.u_max, tolerance / radius) &&
+						   b.circ.SquareDistance(point) < tol2);
+		}
+		case analytic_geometry::plane:
+		{
+			const Standard_Real extent = std::hypot(a.u_max - a.u_min, a.v_max - a.v_min);
+			if (!parallel(a.pln.Axis().Direction(), b.pln.Axis().Direction(), extent, tolerance))
+			{
+				return {};
+			}
+			Standard_Real u, v;
+			ElSLib::Parameters(b.pln, point, u, v);
+			return checked(in_range(u, b.u_min, b.u_max, tolerance) &&
+						   in_range(v, b.v_min, b.v_max, tolerance) &&
+						   b.pln.SquareDistance(point) < tol2);
+		}
+		case analytic_geometry::cylinder:
+		{
+			const Standard_Real radius = b.cyl.Radius();
+			const gp_Lin axis{b.cyl.Axis()};
+			if (std::abs(a.cyl.Radius() - radius) >= tolerance ||
+				!parallel(a.cyl.Axis().Direction(), b.cyl.Axis().Direction(), a.v_max - a.v_min, tolerance) ||
+				axis.SquareDistance(a.cyl.Location()) >= tol2)
+			{
+				return {};
+			}
+			Standard_Real u, v;
+			ElSLib::Parameters(b.cyl, point, u, v);
+			return checked(in_angle_range(u, b.u_min, b.u_max, tolerance / radius) &&
+						   in_range(v, b.v_min, b.v_max, tolerance) &&
+						   std::abs(axis.Distance(point) - radius) < tolerance);
+		}
+		default:
+			return {};
+		}
+	}
+
+	std::optional<gp_Pnt>
+	shape_merger::ProjectPointOnShape(
+		const gp_Pnt &point, const TopoDS_Shape &shape)
+	{
+		if (stats)
+		{
+			stats->num_projections += 1;
+		}
+		return project_point_on_shape(ctx, point, shape);
+	}
+
 	TopTools_ListOfShape
 	shape_merger::FindNearby(
-		const TopoDS_Shape &shape, const TopTools_ListOfShape &others)
+		size_t index, const std::vector<TopoDS_Shape> &others, const BoxTree *tree)
 	{
+		const TopoDS_Shape &shape = others[index];
 		gp_Pnt p1 = PointOnShape(shape);
 
+		std::vector<size_t> candidates;
+		if (tree)
+		{
+			Bnd_Box point;
+			point.Set(p1);
+			BoxSelector selector{point};
+			tree->Select(selector);
+
+			candidates.push_back(index);
+			for (const auto idx : selector.Indices())
+			{
+				candidates.push_back((size_t)idx);
+			}
+			// keep results in bucket order, as without the index
+			std::sort(candidates.begin(), candidates.end());
+			candidates.erase(
+				std::unique(candidates.begin(), candidates.end()),
+				candidates.end());
+		}
+		else
+		{
+			candidates.resize(others.size());
+			std::iota(candidates.begin(), candidates.end(), 0);
+		}
+
 		TopTools_ListOfShape result;
-		for (const TopoDS_Shape &other : others)
+		for (const auto idx : candidates)
 		{
+			const TopoDS_Shape &other = others[idx];
 			if (shape.IsSame(other))
 			{
 				result.Append(other);
 			}
-			else
+			else if (owners && owners->SameSolid(shape, other))
+			{
+				continue;
+			}
+			else if (!BoundingBox(other).IsOut(p1))
 			{
-				if (auto p2 = ProjectPointOnShape(p1, other))
+				if (const auto nearby = AnalyticNearby(p1, shape, other))
+				{
+					if (*nearby)
+					{
+						result.Append(other);
+					}
+				}
+				else if (auto p2 = ProjectPointOnShape(p1, other))
 				{
 					if (p1.SquareDistance(*p2) < tolerance * tolerance)
 					{
@@ -433,13 +984,37 @@ namespace
 			return {};
 		}
 
+		std::vector<TopoDS_Shape> bucket;
+		bucket.reserve((size_t)shapes.Extent());
+		for (const TopoDS_Shape &shape : shapes)
+		{
+			bucket.push_back(shape);
+		}
+
+		std::unique_ptr<BoxTree> tree;
+		if (bucket.size() >= indexed_bucket_size)
+		{
+			tree = std::make_unique<BoxTree>();
+			BoxTreeFiller filler(*tree);
+			for (size_t i = 0; i < bucket.size(); i++)
+			{
+				const Bnd_Box &box = BoundingBox(bucket[i]);
+				if (!box.IsVoid())
+				{
+					filler.Add((Standard_Integer)i, box);
+				}
+			}
+			filler.Fill();
+		}
+
 		TopTools_IndexedDataMapOfShapeListOfShape result;
 
 		TopTools_MapOfShape processed;
 		while (shapes.Extent() != processed.Extent())
 		{
-			for (const TopoDS_Shape &shape : shapes)
+			for (size_t i = 0; i < bucket.size(); i++)
 			{
+				const TopoDS_Shape &shape = bucket[i];
 				if (processed.Contains(shape))
 				{
 					continue;
@@ -452,7 +1027,7 @@ namespace
 					continue;
 				}
 				// note that we expect to find ourselves
-				const auto nearby = FindNearby(shape, shapes);
+				const auto nearby = FindNearby(i, bucket, tree.get());
 				if (nearby.IsEmpty())
 				{
 					throw std::runtime_error("geometric coincidence check failed");
@@ -468,13 +1043,29 @@ namespace
 		return result;
 	}
 
-	void shape_merger::RefineCoincidentShapes(ShapeKeyedShapeList &coincident_shapes)
+	void shape_merger::RefineCoincidentShapes(ShapeKeyedShapeList &coincident_shapes, const Message_ProgressRange &range)
 	{
+		Message_ProgressScope scope{range, "refine", (Standard_Real)coincident_shapes.Extent()};
+
 		TopTools_IndexedDataMapOfShapeListOfShape refined;
-		for (ShapeKeyedShapeList::Iterator it{coincident_shapes}; it.More(); it.Next())
+		for (ShapeKeyedShapeList::Iterator it{coincident_shapes}; it.More(); it.Next(), scope.Next())
 		{
+			check_for_break(scope);
+
 			TopTools_ListOfShape &shapes = it.ChangeValue();
 			//
+			// a bucket from one solid has nothing to glue, keep one shape so
+			// it isn't taken as a group
+			if (owners && std::all_of(
+							  shapes.begin(), shapes.end(), [&](const TopoDS_Shape &shape)
+							  { return owners->SameSolid(shapes.First(), shape); }))
+			{
+				const TopoDS_Shape first = shapes.First();
+				shapes.Clear();
+				shapes.Append(first);
+				continue;
+			}
+			//
 			auto found = FindNearbyPairwise(shapes);
 			decltype(found)::Iterator found_it{found};
 			if (!found_it.More())
@@ -491,7 +1082,7 @@ namespace
 
 		for (decltype(refined)::Iterator it{refined}; it.More(); it.Next())
 		{
-			coincident_shapes.Add({it.Key()}, it.Value());
+			coincident_shapes.Add(MultiShapeKey{key_index.Add(it.Key())}, it.Value());
 		}
 	}
 
@@ -684,26 +1275,79 @@ namespace
 	class gluedetector
 	{
 	public:
-		gluedetector(const TopoDS_Shape &theShape, const Standard_Real aT, IntTools_Context &ctx) : myArgument{theShape},
-																									myTolerance{aT},
-																									merger{ctx, aT}
+		// when owners is non-null only vertices, edges and faces of different
+		// solids are glued
+		gluedetector(const TopoDS_Shape &theShape, const Standard_Real aT, IntTools_Context &ctx, glue_stats *stats,
+					 const solid_owners *owners,
+					 const Message_ProgressRange &range) : myArgument{theShape},
+														   myTolerance{aT},
+														   myStats{stats},
+														   myOwners{owners},
+														   merger{ctx, aT, myKeyIndex, stats, owners}
 		{
+			Message_ProgressScope scope{range, "detect", 3};
 
 			// perform detection
-			DetectVertices();
-			DetectShapes(TopAbs_EDGE);
-			DetectShapes(TopAbs_FACE);
+			{
+				phase_timer timer{myStats, "detect vertices"};
+				DetectVertices(scope.Next());
+			}
+			DetectShapes(TopAbs_EDGE, scope.Next());
+			myArena->Reset(Standard_False);
+			DetectShapes(TopAbs_FACE, scope.Next());
+			myArena->Reset(Standard_False);
 		}
 
-		const TopTools_DataMapOfShapeListOfShape &Images() { return myImages; }
+		// use clusters of vertices found elsewhere, and only look for
+		// coincident edges and faces amongst the candidates (all when null).
+		// as gluing is monotonic in tolerance, the shapes glued at a larger
+		// tolerance are the only candidates at a smaller one
+		gluedetector(const TopoDS_Shape &theShape, const Standard_Real aT, IntTools_Context &ctx, glue_stats *stats,
+					 const TopTools_DataMapOfShapeListOfShape &vertexImages,
+					 const TopTools_MapOfShape *candidates,
+					 const Message_ProgressRange &range) : myArgument{theShape},
+														   myTolerance{aT},
+														   myStats{stats},
+														   myCandidates{candidates},
+														   merger{ctx, aT, myKeyIndex, stats}
+		{
+			Message_ProgressScope scope{range, "detect", 2};
 
-	protected:
-		void DetectVertices();
-		void DetectShapes(const TopAbs_ShapeEnum aType);
-		MultiShapeKey ShapePassKey(const TopoDS_Shape &shape);
+			UseVertexImages(vertexImages);
+			DetectShapes(TopAbs_EDGE, scope.Next());
+			myArena->Reset(Standard_False);
+			DetectShapes(TopAbs_FACE, scope.Next());
+			myArena->Reset(Standard_False);
+		}
+
+		const TopTools_DataMapOfShapeListOfShape &Images() { return myImages; }
+
+		// hand over the images without copying them, leaving ours empty
+		void TakeImages(TopTools_DataMapOfShapeListOfShape &images)
+		{
+			images.Clear();
+			images.Exchange(myImages);
+		}
+
+	protected:
+		void DetectVertices(const Message_ProgressRange &range);
+		void UseVertexImages(const TopTools_DataMapOfShapeListOfShape &vertexImages);
+		void DetectShapes(const TopAbs_ShapeEnum aType, const Message_ProgressRange &range);
+		void InternKeyShapes(const TopAbs_ShapeEnum type);
+		MultiShapeKey ShapePassKey(const TopoDS_Shape &shape) const;
 
 		TopoDS_Shape myArgument;
 		Standard_Real myTolerance;
+		glue_stats *myStats;
+		// when non-null, the only edges and faces that can be glued
+		const TopTools_MapOfShape *myCandidates = nullptr;
+		// when non-null, the solids owning the sub-shapes, see solid_owners
+		const solid_owners *myOwners = nullptr;
+		// for short lived collections, reset once they're gone. nothing kept
+		// in myImages or myOrigins may be allocated from here
+		Handle(NCollection_IncAllocator) myArena = new NCollection_IncAllocator;
+		// shapes that make up pass keys, a key holds indicies into this
+		TopTools_IndexedMapOfShape myKeyIndex;
 		shape_merger merger;
 
 		TopTools_DataMapOfShapeListOfShape myImages;
@@ -711,7 +1355,7 @@ namespace
 	};
 
 	void
-	gluedetector::DetectVertices()
+	gluedetector::DetectVertices(const Message_ProgressRange &range)
 	{
 		TopTools_IndexedMapOfShape verticies;
 
@@ -725,79 +1369,160 @@ namespace
 		VertexTree bounding_tree;
 		fill_tree_with_verticies(bounding_tree, verticies, myTolerance);
 
+		// owning solid of each vertex, indexed as in the tree
+		std::vector<int> owners;
+		if (myOwners)
+		{
+			owners.resize((size_t)verticies.Extent() + 1, solid_owners::not_owned);
+			for (int i = 1; i <= verticies.Extent(); i++)
+			{
+				owners[(size_t)i] = myOwners->Of(verticies(i));
+			}
+		}
+
+		Message_ProgressScope scope{range, "detect vertices", (Standard_Real)verticies.Extent()};
+
 		//
 		//---------------------------------------------------
 		// Chains
 		TColStd_MapOfInteger processed;
 		using IntMapIterator = TColStd_MapOfInteger::Iterator;
 
-		for (int i_vertex = 1; i_vertex <= verticies.Extent(); i_vertex++)
+		for (int i_vertex = 1; i_vertex <= verticies.Extent(); i_vertex++, scope.Next())
 		{
+			check_for_break(scope);
+
 			if (processed.Contains(i_vertex))
 			{
 				continue;
 			}
-
-			TopTools_MapOfShape result;
+			if (myOwners && myOwners->Isolated(verticies(i_vertex)))
+			{
+				processed.Add(i_vertex);
+				continue;
+			}
 
 			{
-				TColStd_MapOfInteger processing;
-				processing.Add(i_vertex);
-				for (;;)
+				TopTools_MapOfShape result{1, myArena};
+
 				{
-					TColStd_MapOfInteger remaining;
-					for (IntMapIterator it{processing}; it.More(); it.Next())
+					TColStd_MapOfInteger processing{1, myArena};
+					processing.Add(i_vertex);
+					for (;;)
 					{
-						const auto &vertex = TopoDS::Vertex(verticies(it.Key()));
-						if (result.Contains(vertex))
+						TColStd_MapOfInteger remaining{1, myArena};
+						for (IntMapIterator it{processing}; it.More(); it.Next())
 						{
-							continue;
-						}
+							const auto &vertex = TopoDS::Vertex(verticies(it.Key()));
+							if (result.Contains(vertex))
+							{
+								continue;
+							}
 
-						VertexSelector nearby{vertex, myTolerance};
-						bounding_tree.Select(nearby);
+							VertexSelector nearby{vertex, myTolerance, myArena};
+							if (myOwners)
+							{
+								nearby.SkipOwner(owners, owners[(size_t)it.Key()]);
+							}
+							bounding_tree.Select(nearby);
 
-						for (auto idx : nearby.Indices())
-						{
-							if (!processing.Contains(idx))
+							for (auto idx : nearby.Indices())
 							{
-								remaining.Add(idx);
+								if (!processing.Contains(idx))
+								{
+									remaining.Add(idx);
+								}
 							}
 						}
+						if (remaining.IsEmpty())
+						{
+							break;
+						}
+						for (IntMapIterator it{processing}; it.More(); it.Next())
+						{
+							processed.Add(it.Key());
+							result.Add(verticies(it.Key()));
+						}
+						processing.Assign(remaining);
 					}
-					if (remaining.IsEmpty())
+					processed.Add(i_vertex);
+				}
+
+				TopTools_MapOfShape::Iterator it{result};
+				if (it.More())
+				{
+					TopoDS_Shape vertex{it.Key()};
+					TopTools_ListOfShape related;
+					for (; it.More(); it.Next())
 					{
-						break;
+						related.Append(it.Key());
+						myOrigins.Bind(it.Key(), vertex);
 					}
-					for (IntMapIterator it{processing}; it.More(); it.Next())
+					myImages.Bind(vertex, related);
+
+					if (myStats && related.Extent() > 1)
 					{
-						processed.Add(it.Key());
-						result.Add(verticies(it.Key()));
+						myStats->num_vertex_clusters += 1;
+						myStats->num_glued_vertices += (size_t)related.Extent();
 					}
-					processing.Assign(remaining);
 				}
-				processed.Add(i_vertex);
 			}
 
-			TopTools_MapOfShape::Iterator it{result};
-			if (it.More())
+			// everything allocated from the arena for this chain has gone
+			myArena->Reset(Standard_False);
+		}
+
+		if (myStats)
+		{
+			myStats->num_vertices += (size_t)verticies.Extent();
+		}
+	}
+
+	void
+	gluedetector::UseVertexImages(const TopTools_DataMapOfShapeListOfShape &vertexImages)
+	{
+		for (TopTools_DataMapOfShapeListOfShape::Iterator it{vertexImages}; it.More(); it.Next())
+		{
+			const TopTools_ListOfShape &related = it.Value();
+			for (const TopoDS_Shape &vertex : related)
 			{
-				TopoDS_Shape vertex{it.Key()};
-				TopTools_ListOfShape related;
-				for (; it.More(); it.Next())
-				{
-					related.Append(it.Key());
-					myOrigins.Bind(it.Key(), vertex);
-				}
-				myImages.Bind(vertex, related);
+				myOrigins.Bind(vertex, it.Key());
 			}
+			myImages.Bind(it.Key(), related);
+
+			if (myStats)
+			{
+				myStats->num_vertex_clusters += 1;
+				myStats->num_glued_vertices += (size_t)related.Extent();
+			}
+		}
+	}
+
+	// add every shape a pass key of edges (faces) can hold to the key index,
+	// so the keys can then be built concurrently with lookups alone
+	void
+	gluedetector::InternKeyShapes(const TopAbs_ShapeEnum type)
+	{
+		TopTools_IndexedMapOfShape members;
+		TopExp::MapShapes(myArgument, type == TopAbs_FACE ? TopAbs_EDGE : TopAbs_VERTEX, members);
+		for (int i = 1; i <= members.Extent(); i++)
+		{
+			const TopoDS_Shape *origin = myOrigins.Seek(members(i));
+			myKeyIndex.Add(origin ? *origin : members(i));
 		}
 	}
 
+	// only reads myOrigins and myKeyIndex, see InternKeyShapes
 	MultiShapeKey
-	gluedetector::ShapePassKey(const TopoDS_Shape &shape)
+	gluedetector::ShapePassKey(const TopoDS_Shape &shape) const
 	{
-		TopTools_ListOfShape parts;
+		const auto key_of = [&](const TopoDS_Shape &member)
+		{
+			const TopoDS_Shape *origin = myOrigins.Seek(member);
+			return myKeyIndex.FindIndex(origin ? *origin : member);
+		};
+
+		MultiShapeKey key;
 		switch (shape.ShapeType())
 		{
 		case TopAbs_FACE:
@@ -808,14 +1533,7 @@ namespace
 				{
 					continue;
 				}
-				if (myOrigins.IsBound(edge))
-				{
-					parts.Append(myOrigins.Find(edge));
-				}
-				else
-				{
-					parts.Append(edge);
-				}
+				key.Add(key_of(edge));
 			}
 			break;
 		case TopAbs_EDGE:
@@ -825,56 +1543,155 @@ namespace
 				const auto orient = vertex.Orientation();
 				if (orient == TopAbs_FORWARD || orient == TopAbs_REVERSED)
 				{
-					if (myOrigins.IsBound(vertex))
-					{
-						parts.Append(myOrigins.Find(vertex));
-					}
-					else
-					{
-						parts.Append(vertex);
-					}
+					key.Add(key_of(vertex));
 				}
 			}
 			break;
 		default:
 			throw std::runtime_error("shape type must be FACE or EDGE");
 		}
-		return {parts};
+		return key;
+	}
+
+	// group equal keys, returning the positions of each group in ascending
+	// order, and the groups in order of their first position, as inserting
+	// the keys one by one into a map would. keys are hash partitioned so the
+	// partitions can be grouped concurrently
+	std::vector<std::vector<int>>
+	group_equal_keys(const std::vector<MultiShapeKey> &keys)
+	{
+		const size_t num_partitions = (size_t)std::max(1, OSD_Parallel::NbLogicalProcessors()) * 4;
+
+		std::vector<size_t> hashes(keys.size());
+		OSD_Parallel::For(0, (int)keys.size(), [&](int i)
+		{
+			hashes[(size_t)i] = keys[(size_t)i].Hash();
+		});
+
+		std::vector<std::vector<int>> partitions(num_partitions);
+		for (size_t i = 0; i < keys.size(); i++)
+		{
+			partitions[hashes[i] % num_partitions].push_back((int)i);
+		}
+
+		std::vector<std::vector<std::vector<int>>> groups_of_partition(num_partitions);
+		OSD_Parallel::For(0, (int)num_partitions, [&](int p)
+		{
+			std::unordered_map<MultiShapeKey, size_t, MultiShapeKey::Hasher, MultiShapeKey::Hasher> group_of_key;
+			auto &groups = groups_of_partition[(size_t)p];
+			for (const int i : partitions[(size_t)p])
+			{
+				const auto found = group_of_key.try_emplace(keys[(size_t)i], groups.size());
+				if (found.second)
+				{
+					groups.emplace_back();
+				}
+				groups[found.first->second].push_back(i);
+			}
+		});
+
+		std::vector<std::vector<int>> groups;
+		for (auto &partition : groups_of_partition)
+		{
+			for (auto &group : partition)
+			{
+				groups.push_back(std::move(group));
+			}
+		}
+		std::sort(groups.begin(), groups.end(), [](const std::vector<int> &a, const std::vector<int> &b)
+				  { return a.front() < b.front(); });
+		return groups;
 	}
 
 	void
-	gluedetector::DetectShapes(const TopAbs_ShapeEnum type)
+	gluedetector::DetectShapes(const TopAbs_ShapeEnum type, const Message_ProgressRange &range)
 	{
 		typedef MultiShapeKeyedList<TopTools_ListOfShape> CoincidentShapeList;
 
-		TopTools_IndexedMapOfShape aMF;
-		TopTools_ListIteratorOfListOfShape aItLS;
-		CoincidentShapeList coincident_shapes;
-		//
-		TopExp::MapShapes(myArgument, type, aMF);
-		//
-		for (decltype(aMF)::Iterator it{aMF}; it.More(); it.Next())
+		const bool is_edge = type == TopAbs_EDGE;
+
+		// refinement is the expensive part
+		Message_ProgressScope scope{range, is_edge ? "detect edges" : "detect faces", 4};
+
+		// buckets only live for this phase, see myArena
+		CoincidentShapeList coincident_shapes{1, myArena};
+
 		{
-			const TopoDS_Shape &shape = it.Value();
+			phase_timer timer{myStats, is_edge ? "bucket edges" : "bucket faces"};
 
-			MultiShapeKey aPKF = ShapePassKey(shape);
+			TopTools_IndexedMapOfShape aMF;
 			//
-			if (coincident_shapes.Contains(aPKF))
+			TopExp::MapShapes(myArgument, type, aMF);
+			//
+			Message_ProgressScope bucket_scope{scope.Next(), "bucket", 3};
+
+			std::vector<TopoDS_Shape> shapes;
+			shapes.reserve((size_t)aMF.Extent());
+			for (decltype(aMF)::Iterator it{aMF}; it.More(); it.Next())
 			{
-				TopTools_ListOfShape &aLSDF = coincident_shapes.ChangeFromKey(aPKF);
-				aLSDF.Append(shape);
+				const TopoDS_Shape &shape = it.Value();
+				if (myCandidates && !myCandidates->Contains(shape))
+				{
+					continue;
+				}
+				if (myOwners && myOwners->Isolated(shape))
+				{
+					continue;
+				}
+				shapes.push_back(shape);
+			}
+			InternKeyShapes(type);
+			bucket_scope.Next();
+			check_for_break(bucket_scope);
+
+			std::vector<MultiShapeKey> keys(shapes.size());
+			OSD_Parallel::For(0, (int)shapes.size(), [&](int i)
+			{
+				keys[(size_t)i] = ShapePassKey(shapes[(size_t)i]);
+			});
+			bucket_scope.Next();
+			check_for_break(bucket_scope);
+
+			// buckets are added in the order of their first shape, and list
+			// their shapes in order, so refinement sees the same buckets as if
+			// they had been built one shape at a time
+			for (const auto &group : group_equal_keys(keys))
+			{
+				TopTools_ListOfShape aLSDF{myArena};
+				for (const int i : group)
+				{
+					aLSDF.Append(shapes[(size_t)i]);
+				}
+				coincident_shapes.Add(keys[(size_t)group.front()], aLSDF);
+			}
+			bucket_scope.Next();
+		}
+
+		if (myStats)
+		{
+			size_t largest = 0;
+			for (CoincidentShapeList::Iterator it{coincident_shapes}; it.More(); it.Next())
+			{
+				largest = std::max(largest, (size_t)it.Value().Extent());
+			}
+			if (is_edge)
+			{
+				myStats->num_edge_buckets += (size_t)coincident_shapes.Extent();
+				myStats->max_edge_bucket = std::max(myStats->max_edge_bucket, largest);
 			}
 			else
 			{
-				TopTools_ListOfShape aLSDF;
-				aLSDF.Append(shape);
-				coincident_shapes.Add(aPKF, aLSDF);
+				myStats->num_face_buckets += (size_t)coincident_shapes.Extent();
+				myStats->max_face_bucket = std::max(myStats->max_face_bucket, largest);
 			}
 		}
 
 		// check geometric coincidence, note this ~50% of total execution time for
 		// me
-		merger.RefineCoincidentShapes(coincident_shapes);
+		{
+			phase_timer timer{myStats, is_edge ? "refine edges" : "refine faces"};
+			merger.RefineCoincidentShapes(coincident_shapes, scope.Next(3));
+		}
 
 		// Images/Origins
 		for (CoincidentShapeList::Iterator it{coincident_shapes}; it.More(); it.Next())
@@ -898,7 +1715,22 @@ namespace
 				continue;
 			}
 			//
-			myImages.Bind(shape, dups);
+			// copied, as a list keeps its allocator
+			myImages.Bound(shape, TopTools_ListOfShape{})->Assign(dups);
+			//
+			if (myStats)
+			{
+				if (is_edge)
+				{
+					myStats->num_edge_groups += 1;
+					myStats->num_glued_edges += (size_t)dups.Extent();
+				}
+				else
+				{
+					myStats->num_face_groups += 1;
+					myStats->num_glued_faces += (size_t)dups.Extent();
+				}
+			}
 			//
 			// origins
 			for (const TopoDS_Shape &dup : dups)
@@ -911,439 +1743,2393 @@ namespace
 		}
 	}
 
-	class geomgluer2
+	// replacements of rebuilt shapes, kept separately for each type of shape
+	// so a type can be released once nothing rebuilt later refers to it
+	class shape_origins
 	{
+		std::array<TopTools_DataMapOfShapeShape, TopAbs_SHAPE> maps;
+
 	public:
-		geomgluer2(const TopoDS_Shape &theShape) : myArgument{theShape},
-												   myContext{new IntTools_Context{}}
+		Standard_Boolean IsBound(const TopoDS_Shape &shape) const
 		{
+			return maps[shape.ShapeType()].IsBound(shape);
 		}
 
-		TopoDS_Shape Perform(Standard_Real tolerance);
-
-	protected:
-		TopoDS_Shape BuildResult();
-
-		void FillVertices();
-		void FillCompounds();
-		void FillBRepShapes(const TopAbs_ShapeEnum theType);
-		void FillContainers(const TopAbs_ShapeEnum theType);
-		void FillCompound(const TopoDS_Shape &theC);
-
-		TopoDS_Shape CopyBRepShape(const TopoDS_Shape &source);
-		TopoDS_Edge CopyEdge(const TopoDS_Edge source);
-		TopoDS_Face CopyFace(const TopoDS_Face source);
+		const TopoDS_Shape &Find(const TopoDS_Shape &shape) const
+		{
+			return maps[shape.ShapeType()].Find(shape);
+		}
 
-		bool is_bound_in_origins(const TopoDS_Shape &shape) const;
-		bool is_child_bound_in_origins(const TopoDS_Shape &shape) const;
+		void Bind(const TopoDS_Shape &shape, const TopoDS_Shape &replacement)
+		{
+			maps[shape.ShapeType()].Bind(shape, replacement);
+		}
 
-	protected:
-		const TopoDS_Shape myArgument;
-		const Handle(IntTools_Context) myContext;
+		const TopTools_DataMapOfShapeShape &OfType(const TopAbs_ShapeEnum type) const
+		{
+			return maps[type];
+		}
 
-		TopTools_DataMapOfShapeListOfShape myImagesToWork;
-		TopTools_DataMapOfShapeShape myOriginsToWork;
-		TopTools_DataMapOfShapeShape myOrigins;
+		void Release(const TopAbs_ShapeEnum type)
+		{
+			maps[type].Clear(Standard_True);
+		}
 	};
 
+	// true when the shape is made of solids, possibly in nested compounds.
+	// otherwise it could hold free faces, edges, etc. that refer to origins
+	// of any type until the result is built
 	bool
-	geomgluer2::is_child_bound_in_origins(const TopoDS_Shape &shape) const
+	only_solids(const TopoDS_Shape &shape)
 	{
-		if (myOrigins.IsBound(shape))
-		{
-			return true;
-		}
-		if (isCompoundShape(shape))
+		switch (shape.ShapeType())
 		{
+		case TopAbs_COMPOUND:
 			for (TopoDS_Iterator it{shape}; it.More(); it.Next())
 			{
-				if (is_child_bound_in_origins(it.Value()))
+				if (!only_solids(it.Value()))
 				{
-					return true;
+					return false;
 				}
 			}
+			return true;
+		case TopAbs_COMPSOLID:
+		case TopAbs_SOLID:
+			return true;
+		default:
+			return false;
 		}
-		return false;
 	}
 
-	bool
-	geomgluer2::is_bound_in_origins(const TopoDS_Shape &shape) const
+	// sorted indices of the children owning each sub-shape of the given type
+	typedef NCollection_DataMap<TopoDS_Shape, std::vector<size_t>, TopTools_ShapeMapHasher> OwnerMap;
+
+	void
+	map_owners(const std::vector<TopoDS_Shape> &children, const TopAbs_ShapeEnum type, OwnerMap &owners)
 	{
-		if (myOrigins.IsBound(shape))
-		{
-			return true;
-		}
-		for (TopoDS_Iterator it{shape}; it.More(); it.Next())
+		for (size_t i = 0; i < children.size(); i++)
 		{
-			if (is_child_bound_in_origins(it.Value()))
+			TopTools_IndexedMapOfShape shapes;
+			TopExp::MapShapes(children[i], type, shapes);
+			for (int j = 1; j <= shapes.Extent(); j++)
 			{
-				return true;
+				const TopoDS_Shape &shape = shapes(j);
+				if (std::vector<size_t> *found = owners.ChangeSeek(shape))
+				{
+					found->push_back(i);
+				}
+				else
+				{
+					owners.Bind(shape, {i});
+				}
 			}
 		}
-		return false;
 	}
 
-	TopoDS_Shape
-	geomgluer2::Perform(Standard_Real tolerance)
+	// what the near miss search needs of each shape, worked out once rather
+	// than for every pair it's in. vertices are indices into a map of all the
+	// vertices of the result, sorted
+	struct near_miss_side
 	{
-		gluedetector detector{myArgument, tolerance, *myContext};
+		const std::vector<size_t> *solids = nullptr;
+		Bnd_Box box;
+		gp_Pnt point;
+		std::vector<int> vertices;
+	};
 
-		myImagesToWork = detector.Images();
-		myOriginsToWork.Clear();
+	// whether two sorted index lists have an index in common
+	template <typename T>
+	bool
+	intersect(const std::vector<T> &a, const std::vector<T> &b)
+	{
+		return std::any_of(a.begin(), a.end(), [&](const T &idx)
+						   { return std::binary_search(b.begin(), b.end(), idx); });
+	}
 
-		if (!myImagesToWork.Extent())
+	// search the glued `shape` for vertices (edges, faces) of different
+	// children that came within reach of each other but weren't glued, and
+	// report them against the children owning each side. shapes glued, even
+	// through others, are one shape by now, and shapes already sharing a
+	// vertex, e.g. faces meeting at a glued edge, are left out. edges and
+	// faces are measured as the coincidence check does, from a point of each
+	// to the other, and kept when both are within reach. shapes are searched
+	// from concurrently, in runs that each have their own context
+	void
+	report_near_misses(
+		const TopoDS_Shape &shape, Standard_Real tolerance, Standard_Real reach,
+		glue_stats &stats, const Message_ProgressRange &range)
+	{
+		std::vector<TopoDS_Shape> children;
+		for (TopoDS_Iterator it{shape}; it.More(); it.Next())
 		{
-			spdlog::warn("no shapes to glue detected");
-			return myArgument;
+			children.push_back(it.Value());
 		}
+		OwnerMap owners;
+		map_owners(children, TopAbs_VERTEX, owners);
+		map_owners(children, TopAbs_EDGE, owners);
+		map_owners(children, TopAbs_FACE, owners);
 
-		for (decltype(myImagesToWork)::Iterator it{myImagesToWork}; it.More(); it.Next())
-		{
-			const TopoDS_Shape &key = it.Key();
-
-			for (const TopoDS_Shape &shape : it.Value())
-			{
-				myOriginsToWork.Bind(shape, key);
-			}
-		}
+		TopTools_IndexedMapOfShape all_vertices;
+		TopExp::MapShapes(shape, TopAbs_VERTEX, all_vertices);
 
-		FillVertices();
-		FillBRepShapes(TopAbs_EDGE);
-		FillContainers(TopAbs_WIRE);
-		FillBRepShapes(TopAbs_FACE);
-		FillContainers(TopAbs_SHELL);
-		FillContainers(TopAbs_SOLID);
-		FillContainers(TopAbs_COMPSOLID);
-		FillCompounds();
+		const std::vector<size_t> no_solids;
+		const auto position = [](const gp_Pnt &point)
+		{
+			return std::array<double, 3>{point.X(), point.Y(), point.Z()};
+		};
 
-		auto result = BuildResult();
-		BRepLib::SameParameter(result, tolerance, Standard_True);
+		Message_ProgressScope scope{range, "report near misses", 3};
+		std::vector<glue_near_miss> report;
+		for (const auto &[type, name] : {
+				 std::make_pair(TopAbs_VERTEX, "vertex"),
+				 std::make_pair(TopAbs_EDGE, "edge"),
+				 std::make_pair(TopAbs_FACE, "face"),
+			 })
+		{
+			Message_ProgressScope type_scope{scope.Next(), name, 10};
 
-		return result;
-	}
+			TopTools_IndexedMapOfShape shapes;
+			TopExp::MapShapes(shape, type, shapes);
+			const int num_shapes = shapes.Extent();
 
-	void
-	geomgluer2::FillVertices()
-	{
-		for (decltype(myImagesToWork)::Iterator it{myImagesToWork}; it.More(); it.Next())
-		{
-			const TopoDS_Shape &key = it.Key();
-			if (key.ShapeType() != TopAbs_VERTEX)
-			{
-				continue;
-			}
-			const TopTools_ListOfShape &verticies = it.Value();
-			TopoDS_Vertex result;
-			BOPTools_AlgoTools::MakeVertex(verticies, result);
-			for (const auto &vertex : verticies)
+			// degenerated edges have no curve to measure from, and are left
+			// with a void box
+			std::vector<near_miss_side> sides((size_t)num_shapes);
+			OSD_Parallel::For(0, num_shapes, [&](int i)
 			{
-				myOrigins.Bind(vertex, result);
-			}
-		}
-	}
+				const TopoDS_Shape &current = shapes(i + 1);
+				near_miss_side &side = sides[(size_t)i];
+				const std::vector<size_t> *found = owners.Seek(current);
+				side.solids = found ? found : &no_solids;
+				if (type == TopAbs_EDGE && BRep_Tool::Degenerated(TopoDS::Edge(current)))
+				{
+					return;
+				}
+				side.box = inflated_bounding_box(current, reach);
+				if (type == TopAbs_VERTEX)
+				{
+					side.point = BRep_Tool::Pnt(TopoDS::Vertex(current));
+					return;
+				}
+				side.point = PointOnShape(current);
+				for (TopExp_Explorer exp{current, TopAbs_VERTEX}; exp.More(); exp.Next())
+				{
+					side.vertices.push_back(all_vertices.FindIndex(exp.Current()));
+				}
+				std::sort(side.vertices.begin(), side.vertices.end());
+			});
+			type_scope.Next();
+			check_for_break(type_scope);
 
-	void
-	geomgluer2::FillBRepShapes(const TopAbs_ShapeEnum theType)
-	{
-		TopTools_MapOfShape processed;
-		//
-		for (TopExp_Explorer ex{myArgument, theType}; ex.More(); ex.Next())
-		{
-			const TopoDS_Shape &original = ex.Current();
-			//
-			if (!processed.Add(original))
+			BoxTree tree;
 			{
-				continue;
+				BoxTreeFiller filler(tree);
+				for (int i = 1; i <= num_shapes; i++)
+				{
+					if (!sides[(size_t)i - 1].box.IsVoid())
+					{
+						filler.Add(i, sides[(size_t)i - 1].box);
+					}
+				}
+				filler.Fill();
 			}
-			//
-			bool bIsToWork = myOriginsToWork.IsBound(original);
-			if (!is_bound_in_origins(original) && !bIsToWork)
+			type_scope.Next();
+			check_for_break(type_scope);
+
+			// progress ranges have to be made up front, each is then used by
+			// only one thread
+			const int num_runs = std::min(num_shapes, std::max(1, OSD_Parallel::NbLogicalProcessors()) * 4);
+			Message_ProgressScope search_scope{type_scope.Next(8), "search", (Standard_Real)std::max(num_runs, 1)};
+			std::vector<Message_ProgressRange> ranges;
+			for (int run = 0; run < num_runs; run++)
 			{
-				continue;
+				ranges.push_back(search_scope.Next());
 			}
-			//
-			TopoDS_Shape replacement = CopyBRepShape(original);
-			//
-			// myImages / myOrigins
-			if (bIsToWork)
+
+			std::vector<std::vector<glue_near_miss>> found((size_t)num_runs);
+			std::atomic<bool> cancelled{false};
+			OSD_Parallel::For(0, num_runs, [&](int run)
 			{
-				const TopoDS_Shape &aSkey = myOriginsToWork.Find(original);
-				//
-				for (const auto &aEx : myImagesToWork.Find(aSkey))
+				Handle(IntTools_Context) context = new IntTools_Context{};
+				const int first = (int)((long long)num_shapes * run / num_runs) + 1;
+				const int last = (int)((long long)num_shapes * (run + 1) / num_runs);
+				Message_ProgressScope run_scope{ranges[(size_t)run], nullptr, (Standard_Real)(last - first + 1)};
+				for (int i = first; i <= last; i++, run_scope.Next())
 				{
-					myOrigins.Bind(aEx, replacement);
-					processed.Add(aEx);
-				}
+					if (cancelled || run_scope.UserBreak())
+					{
+						cancelled = true;
+						return;
+					}
+
+					const near_miss_side &side_a = sides[(size_t)i - 1];
+					if (side_a.box.IsVoid())
+					{
+						continue;
+					}
+					const TopoDS_Shape &a = shapes(i);
+
+					BoxSelector nearby{side_a.box};
+					tree.Select(nearby);
+					for (const Standard_Integer j : nearby.Indices())
+					{
+						// each pair once
+						if (j <= i)
+						{
+							continue;
+						}
+						const near_miss_side &side_b = sides[(size_t)j - 1];
+						if (intersect(*side_a.solids, *side_b.solids) ||
+							intersect(side_a.vertices, side_b.vertices))
+						{
+							continue;
+						}
+						const TopoDS_Shape &b = shapes(j);
+
+						gp_Pnt point_b = side_b.point;
+						Standard_Real needed;
+						if (type == TopAbs_VERTEX)
+						{
+							needed = vertex_pair_tolerance(TopoDS::Vertex(a), TopoDS::Vertex(b));
+						}
+						else
+						{
+							// the second projection is only needed when the
+							// first is within reach
+							const auto on_b = project_point_on_shape(*context, side_a.point, b);
+							if (!on_b || side_a.point.Distance(*on_b) > reach)
+							{
+								continue;
+							}
+							const auto on_a = project_point_on_shape(*context, side_b.point, a);
+							if (!on_a)
+							{
+								continue;
+							}
+							needed = std::max(side_a.point.Distance(*on_b), side_b.point.Distance(*on_a));
+							point_b = *on_b;
+						}
+						if (needed <= tolerance || needed > reach)
+						{
+							continue;
+						}
+
+						glue_near_miss entry;
+						entry.type = name;
+						entry.tolerance = needed;
+						entry.solids_a = *side_a.solids;
+						entry.solids_b = *side_b.solids;
+						entry.position_a = position(side_a.point);
+						entry.position_b = position(point_b);
+						found[(size_t)run].push_back(std::move(entry));
+					}
+				}
+			});
+			if (cancelled)
+			{
+				throw glue_cancelled{"reporting near misses was cancelled"};
 			}
-			else
+
+			for (auto &run : found)
+			{
+				report.insert(report.end(), std::make_move_iterator(run.begin()), std::make_move_iterator(run.end()));
+			}
+		}
+
+		std::sort(report.begin(), report.end(), [](const glue_near_miss &a, const glue_near_miss &b)
+				  { return std::tie(a.tolerance, a.solids_a, a.solids_b) < std::tie(b.tolerance, b.solids_a, b.solids_b); });
+		stats.near_misses.insert(
+			stats.near_misses.end(),
+			std::make_move_iterator(report.begin()), std::make_move_iterator(report.end()));
+	}
+
+	// report near misses of the glued result out to near_miss_tolerance, when
+	// asked for
+	void
+	report_near_misses(
+		const TopoDS_Shape &glued, Standard_Real tolerance,
+		Standard_Real near_miss_tolerance, glue_stats *stats,
+		const Message_ProgressRange &range)
+	{
+		if (!stats || !(near_miss_tolerance > tolerance))
+		{
+			return;
+		}
+		phase_timer timer{stats, "report near misses"};
+		report_near_misses(glued, tolerance, near_miss_tolerance, *stats, range);
+	}
+
+	class geomgluer2
+	{
+	public:
+		geomgluer2(const TopoDS_Shape &theShape, glue_stats *stats = nullptr) : myArgument{theShape},
+																			   myContext{new IntTools_Context{}},
+																			   myStats{stats}
+		{
+		}
+
+		// sub-shapes of `fixed` are never rebuilt or modified, not even their
+		// tolerances. where they coincide with other shapes they are reused as
+		// the glued result
+		void SetFixed(const TopoDS_Shape &fixed)
+		{
+			TopExp::MapShapes(fixed, myFixed);
+		}
+
+		// only glue vertices, edges and faces of different solids
+		void SetCrossSolidOnly(bool cross_solid_only)
+		{
+			myCrossSolidOnly = cross_solid_only;
+		}
+
+		TopoDS_Shape Perform(Standard_Real tolerance, const Message_ProgressRange &range);
+
+		// glue the coincident shapes found by a gluedetector, the images are
+		// taken over rather than copied
+		TopoDS_Shape Perform(
+			Standard_Real tolerance, TopTools_DataMapOfShapeListOfShape &&images,
+			const Message_ProgressRange &range);
+
+	protected:
+		TopoDS_Shape BuildResult();
+
+		TopoDS_Shape FindFixed(const TopTools_ListOfShape &shapes) const;
+
+		void CollectModifiedEdges();
+		void SameParameterModifiedEdges(Standard_Real tolerance);
+
+		void FillVertices(const Message_ProgressRange &range);
+		void RejectInconsistent(const TopAbs_ShapeEnum type);
+		void FillCompounds(const Message_ProgressRange &range);
+		void FillBRepShapes(const TopAbs_ShapeEnum theType, const Message_ProgressRange &range);
+		void FillContainers(const TopAbs_ShapeEnum theType, const Message_ProgressRange &range);
+		void FillCompound(const TopoDS_Shape &theC);
+
+		void IndexContainers(const TopoDS_Shape &shape);
+		void MarkTouched(const TopAbs_ShapeEnum type);
+		bool IsTouched(const TopoDS_Shape &container) const;
+
+		TopoDS_Shape CopyBRepShape(const TopoDS_Shape &source);
+		TopoDS_Edge CopyEdge(const TopoDS_Edge source);
+		TopoDS_Face CopyFace(const TopoDS_Face source);
+
+		bool is_bound_in_origins(const TopoDS_Shape &shape) const;
+
+	protected:
+		const TopoDS_Shape myArgument;
+		const Handle(IntTools_Context) myContext;
+		glue_stats *myStats;
+
+		TopTools_DataMapOfShapeListOfShape myImagesToWork;
+		TopTools_DataMapOfShapeShape myOriginsToWork;
+		shape_origins myOrigins;
+		TopTools_MapOfShape myFixed;
+		bool myCrossSolidOnly = false;
+		// vertices, edges and faces taken out of their groups as they
+		// couldn't be glued onto the fixed shape, see FillVertices
+		size_t myNumUnglued = 0;
+		// edges FillBRepShapes created or reused as glued edges
+		TopTools_IndexedMapOfShape myModifiedEdges;
+		// wires, shells, solids, compsolids and compounds of the argument,
+		// each after those inside it, and whether each has a replaced shape
+		// below it so has to be rebuilt
+		TopTools_IndexedMapOfShape myContainers;
+		std::vector<bool> myTouched;
+	};
+
+	TopoDS_Shape
+	geomgluer2::FindFixed(const TopTools_ListOfShape &shapes) const
+	{
+		for (const auto &shape : shapes)
+		{
+			if (myFixed.Contains(shape))
+			{
+				return shape;
+			}
+		}
+		return {};
+	}
+
+	// for edges and faces, whose children are never compounds, so replaced
+	// shapes below them are direct children
+	bool
+	geomgluer2::is_bound_in_origins(const TopoDS_Shape &shape) const
+	{
+		if (myOrigins.IsBound(shape))
+		{
+			return true;
+		}
+		for (TopoDS_Iterator it{shape}; it.More(); it.Next())
+		{
+			if (myOrigins.IsBound(it.Value()))
+			{
+				return true;
+			}
+		}
+		return false;
+	}
+
+	void
+	geomgluer2::IndexContainers(const TopoDS_Shape &shape)
+	{
+		const TopAbs_ShapeEnum type = shape.ShapeType();
+		if (type == TopAbs_EDGE || type == TopAbs_VERTEX || myContainers.Contains(shape))
+		{
+			return;
+		}
+		for (TopoDS_Iterator it{shape}; it.More(); it.Next())
+		{
+			IndexContainers(it.Value());
+		}
+		// faces are only passed through to reach their wires
+		if (type != TopAbs_FACE)
+		{
+			myContainers.Add(shape);
+		}
+	}
+
+	// one pass over the containers of the type, which works as those inside
+	// them have already been marked (or filled, for edges and faces). this
+	// replaces searching down through every container for a replaced shape
+	void
+	geomgluer2::MarkTouched(const TopAbs_ShapeEnum type)
+	{
+		myTouched.resize((size_t)myContainers.Extent(), false);
+		for (int i = 1; i <= myContainers.Extent(); i++)
+		{
+			const TopoDS_Shape &container = myContainers(i);
+			if (container.ShapeType() != type)
+			{
+				continue;
+			}
+			bool touched = false;
+			for (TopoDS_Iterator it{container}; it.More() && !touched; it.Next())
+			{
+				const TopoDS_Shape &child = it.Value();
+				const Standard_Integer index = myContainers.FindIndex(child);
+				touched = index ? myTouched[(size_t)index - 1] : myOrigins.IsBound(child);
+			}
+			myTouched[(size_t)i - 1] = touched;
+		}
+	}
+
+	bool
+	geomgluer2::IsTouched(const TopoDS_Shape &container) const
+	{
+		const Standard_Integer index = myContainers.FindIndex(container);
+		return index && myTouched[(size_t)index - 1];
+	}
+
+	TopoDS_Shape
+	geomgluer2::Perform(Standard_Real tolerance, const Message_ProgressRange &range)
+	{
+		// detection takes about half the time
+		Message_ProgressScope scope{range, "glue", 2};
+
+		// the detector's buckets, key index and bounding boxes go before
+		// filling starts, as do the projectors it caches for the coincidence
+		// checks in its own context
+		TopTools_DataMapOfShapeListOfShape images;
+		{
+			Handle(IntTools_Context) context = new IntTools_Context{};
+
+			std::optional<solid_owners> owners;
+			if (myCrossSolidOnly)
+			{
+				phase_timer timer{myStats, "map owners"};
+				owners.emplace(myArgument, tolerance);
+			}
+			gluedetector detector{
+				myArgument, tolerance, *context, myStats,
+				owners ? &*owners : nullptr, scope.Next()};
+			detector.TakeImages(images);
+		}
+
+		return Perform(tolerance, std::move(images), scope.Next());
+	}
+
+	TopoDS_Shape
+	geomgluer2::Perform(
+		Standard_Real tolerance, TopTools_DataMapOfShapeListOfShape &&images,
+		const Message_ProgressRange &range)
+	{
+		if (myStats)
+		{
+			myStats->num_clusters += 1;
+		}
+
+		// weights are rough proportions of time spent in each step
+		Message_ProgressScope scope{range, "fill", 10};
+
+		myImagesToWork.Clear();
+		myImagesToWork.Exchange(images);
+		myOriginsToWork.Clear();
+		myNumUnglued = 0;
+
+		if (!myImagesToWork.Extent())
+		{
+			spdlog::warn("no shapes to glue detected");
+			return myArgument;
+		}
+
+		for (decltype(myImagesToWork)::Iterator it{myImagesToWork}; it.More(); it.Next())
+		{
+			const TopoDS_Shape &key = it.Key();
+
+			for (const TopoDS_Shape &shape : it.Value())
+			{
+				myOriginsToWork.Bind(shape, key);
+			}
+		}
+
+		{
+			phase_timer timer{myStats, "fill vertices"};
+			FillVertices(scope.Next());
+		}
+		{
+			phase_timer timer{myStats, "fill edges"};
+			RejectInconsistent(TopAbs_EDGE);
+			FillBRepShapes(TopAbs_EDGE, scope.Next(2));
+			CollectModifiedEdges();
+		}
+
+		// each type of shape is only referred to by the type containing it,
+		// so can be released once that's been rebuilt. this keeps the peak
+		// down to about two levels of origins
+		const bool release_origins = only_solids(myArgument);
+
+		if (release_origins)
+		{
+			myOrigins.Release(TopAbs_VERTEX);
+		}
+		{
+			phase_timer timer{myStats, "fill wires"};
+			IndexContainers(myArgument);
+			FillContainers(TopAbs_WIRE, scope.Next());
+		}
+		{
+			phase_timer timer{myStats, "fill faces"};
+			RejectInconsistent(TopAbs_FACE);
+			FillBRepShapes(TopAbs_FACE, scope.Next(2));
+		}
+		myImagesToWork.Clear(Standard_True);
+		myOriginsToWork.Clear(Standard_True);
+		if (release_origins)
+		{
+			myOrigins.Release(TopAbs_EDGE);
+			myOrigins.Release(TopAbs_WIRE);
+		}
+		{
+			phase_timer timer{myStats, "fill containers"};
+			FillContainers(TopAbs_SHELL, scope.Next());
+			if (release_origins)
+			{
+				myOrigins.Release(TopAbs_FACE);
+			}
+			FillContainers(TopAbs_SOLID, scope.Next());
+			if (release_origins)
+			{
+				myOrigins.Release(TopAbs_SHELL);
+			}
+			FillContainers(TopAbs_COMPSOLID, scope.Next());
+			FillCompounds(scope.Next());
+		}
+		myContainers.Clear(Standard_True);
+		myTouched.clear();
+
+		TopoDS_Shape result;
+		{
+			phase_timer timer{myStats, "build result"};
+			result = BuildResult();
+		}
+		check_for_break(scope);
+		{
+			phase_timer timer{myStats, "same parameter"};
+			SameParameterModifiedEdges(tolerance);
+		}
+		if (myStats)
+		{
+			myStats->num_unglued += myNumUnglued;
+		}
+
+		return result;
+	}
+
+	void
+	geomgluer2::CollectModifiedEdges()
+	{
+		// edges are modified in place, so distinct entries mustn't share a
+		// TShape through different locations. fixed edges reused as glued
+		// edges belong to the fixed shape, which is left as it was
+		const auto &edges = myOrigins.OfType(TopAbs_EDGE);
+		for (TopTools_DataMapOfShapeShape::Iterator it{edges}; it.More(); it.Next())
+		{
+			if (!myFixed.Contains(it.Value()))
 			{
-				myOrigins.Bind(original, replacement);
+				myModifiedEdges.Add(it.Value().Located(TopLoc_Location{}).Oriented(TopAbs_FORWARD));
 			}
 		}
 	}
 
+	// equivalent to a forced BRepLib::SameParameter over the result, but only
+	// visits the edges FillBRepShapes created or reused as glued edges, these
+	// being the only ones to gain new pcurves
 	void
-	geomgluer2::FillContainers(const TopAbs_ShapeEnum type)
+	geomgluer2::SameParameterModifiedEdges(Standard_Real tolerance)
 	{
+		const TopTools_IndexedMapOfShape &edges = myModifiedEdges;
+
+		// vertices can be shared between edges, so their tolerances are
+		// updated afterwards rather than from inside the parallel loop
+		std::vector<Standard_Real> edge_tolerances((size_t)edges.Extent(), -1.);
+		OSD_Parallel::For(1, edges.Extent() + 1, [&](int i)
+		{
+			const TopoDS_Edge &edge = TopoDS::Edge(edges(i));
+			BRep_Builder builder;
+			builder.SameRange(edge, Standard_False);
+			builder.SameParameter(edge, Standard_False);
+			BRepLib::SameParameter(edge, tolerance, edge_tolerances[(size_t)i - 1], Standard_True);
+		});
+
 		BRep_Builder builder;
+		for (int i = 1; i <= edges.Extent(); i++)
+		{
+			const Standard_Real edge_tolerance = edge_tolerances[(size_t)i - 1];
+			if (edge_tolerance <= 0)
+			{
+				continue;
+			}
+			TopoDS_Vertex v1, v2;
+			TopExp::Vertices(TopoDS::Edge(edges(i)), v1, v2);
+			if (!v1.IsNull() && !myFixed.Contains(v1))
+			{
+				builder.UpdateVertex(v1, edge_tolerance);
+			}
+			if (!v2.IsNull() && !myFixed.Contains(v2))
+			{
+				builder.UpdateVertex(v2, edge_tolerance);
+			}
+		}
+	}
 
-		TopTools_MapOfShape processed;
+	void
+	geomgluer2::FillVertices(const Message_ProgressRange &range)
+	{
+		Message_ProgressScope scope{range, "fill vertices", 1};
+
+		for (decltype(myImagesToWork)::Iterator it{myImagesToWork}; it.More(); it.Next())
+		{
+			check_for_break(scope);
+
+			const TopoDS_Shape &key = it.Key();
+			if (key.ShapeType() != TopAbs_VERTEX)
+			{
+				continue;
+			}
+			const TopTools_ListOfShape &verticies = it.Value();
+			const TopoDS_Shape anchor = FindFixed(verticies);
+			if (anchor.IsNull())
+			{
+				TopoDS_Vertex result;
+				BOPTools_AlgoTools::MakeVertex(verticies, result);
+				for (const auto &vertex : verticies)
+				{
+					myOrigins.Bind(vertex, result);
+				}
+				continue;
+			}
+
+			// the fixed vertex is reused as it is, growing its tolerance would
+			// change the fixed shape, which other solids still use. vertices
+			// outside it are glued to each other instead, and the edges and
+			// faces on them are taken out of their groups by RejectInconsistent
+			const TopoDS_Vertex &fixed = TopoDS::Vertex(anchor);
+			const gp_Pnt point = BRep_Tool::Pnt(fixed);
+			const Standard_Real tolerance = BRep_Tool::Tolerance(fixed);
+			TopTools_ListOfShape uncovered;
+			for (const auto &vertex : verticies)
+			{
+				if (myFixed.Contains(vertex))
+				{
+					continue;
+				}
+				const TopoDS_Vertex &other = TopoDS::Vertex(vertex);
+				if (point.Distance(BRep_Tool::Pnt(other)) + BRep_Tool::Tolerance(other) > tolerance)
+				{
+					uncovered.Append(vertex);
+				}
+				else
+				{
+					myOrigins.Bind(vertex, fixed);
+				}
+			}
+			myNumUnglued += (size_t)uncovered.Extent();
+			if (uncovered.Extent() > 1)
+			{
+				TopoDS_Vertex result;
+				BOPTools_AlgoTools::MakeVertex(uncovered, result);
+				for (const auto &vertex : uncovered)
+				{
+					myOrigins.Bind(vertex, result);
+				}
+			}
+		}
+
+		if (myNumUnglued)
+		{
+			spdlog::warn(
+				"{} vertices left unglued, as the fixed vertices they coincide with don't cover them",
+				myNumUnglued);
+		}
+	}
+
+	// the edges (faces) of a group are replaced by one of them, so each must
+	// already have the same glued vertices (edges) as it. that only fails
+	// below vertices FillVertices kept off a fixed vertex, and those edges
+	// (faces) are left unglued rather than built on the wrong vertices. the
+	// children compared are those the detector's pass keys are made of
+	void
+	geomgluer2::RejectInconsistent(const TopAbs_ShapeEnum type)
+	{
+		if (!myNumUnglued)
+		{
+			return;
+		}
+
+		const TopAbs_ShapeEnum child_type = type == TopAbs_FACE ? TopAbs_EDGE : TopAbs_VERTEX;
+		const auto glued_children = [&](const TopoDS_Shape &shape, TopTools_MapOfShape &children)
+		{
+			children.Clear();
+			for (TopExp_Explorer ex{shape, child_type}; ex.More(); ex.Next())
+			{
+				const TopoDS_Shape &child = ex.Current();
+				if (type == TopAbs_FACE && BRep_Tool::Degenerated(TopoDS::Edge(child)))
+				{
+					continue;
+				}
+				if (type == TopAbs_EDGE &&
+					child.Orientation() != TopAbs_FORWARD && child.Orientation() != TopAbs_REVERSED)
+				{
+					continue;
+				}
+				children.Add(myOrigins.IsBound(child) ? myOrigins.Find(child) : child);
+			}
+		};
+
+		size_t num_rejected = 0;
+		TopTools_MapOfShape expected, children;
+		for (decltype(myImagesToWork)::Iterator it{myImagesToWork}; it.More(); it.Next())
+		{
+			if (it.Key().ShapeType() != type)
+			{
+				continue;
+			}
+			TopTools_ListOfShape &shapes = it.ChangeValue();
+			TopoDS_Shape replacement = FindFixed(shapes);
+			if (replacement.IsNull())
+			{
+				replacement = shapes.First();
+			}
+			glued_children(replacement, expected);
+			for (TopTools_ListOfShape::Iterator member{shapes}; member.More();)
+			{
+				glued_children(member.Value(), children);
+				if (children.Extent() == expected.Extent() && children.Contains(expected))
+				{
+					member.Next();
+					continue;
+				}
+				myOriginsToWork.UnBind(member.Value());
+				shapes.Remove(member);
+				num_rejected += 1;
+			}
+		}
+
+		myNumUnglued += num_rejected;
+		if (num_rejected)
+		{
+			spdlog::warn(
+				"{} {} left unglued, as they are on vertices that couldn't be glued",
+				num_rejected, type == TopAbs_FACE ? "faces" : "edges");
+		}
+	}
+
+	void
+	geomgluer2::FillBRepShapes(const TopAbs_ShapeEnum theType, const Message_ProgressRange &range)
+	{
+		Message_ProgressScope scope{range, theType == TopAbs_EDGE ? "fill edges" : "fill faces", 1};
+
+		TopTools_MapOfShape processed;
+		//
+		for (TopExp_Explorer ex{myArgument, theType}; ex.More(); ex.Next())
+		{
+			check_for_break(scope);
+
+			const TopoDS_Shape &original = ex.Current();
+			//
+			if (!processed.Add(original))
+			{
+				continue;
+			}
+			//
+			bool bIsToWork = myOriginsToWork.IsBound(original);
+			if (!is_bound_in_origins(original) && !bIsToWork)
+			{
+				continue;
+			}
+			//
+			// myImages / myOrigins
+			if (bIsToWork)
+			{
+				const TopoDS_Shape &aSkey = myOriginsToWork.Find(original);
+				const TopTools_ListOfShape &coincident = myImagesToWork.Find(aSkey);
+				//
+				TopoDS_Shape replacement = FindFixed(coincident);
+				if (replacement.IsNull())
+				{
+					replacement = CopyBRepShape(original);
+				}
+				//
+				for (const auto &aEx : coincident)
+				{
+					if (!myFixed.Contains(aEx))
+					{
+						myOrigins.Bind(aEx, replacement);
+					}
+					processed.Add(aEx);
+				}
+			}
+			else
+			{
+				myOrigins.Bind(original, CopyBRepShape(original));
+			}
+		}
+	}
+
+	void
+	geomgluer2::FillContainers(const TopAbs_ShapeEnum type, const Message_ProgressRange &range)
+	{
+		Message_ProgressScope scope{range, "fill containers", 1};
+
+		BRep_Builder builder;
+
+		MarkTouched(type);
+		for (int i = 1; i <= myContainers.Extent(); i++)
+		{
+			check_for_break(scope);
+
+			const TopoDS_Shape &original = myContainers(i);
+			if (original.ShapeType() != type || !myTouched[(size_t)i - 1])
+			{
+				continue;
+			}
+			//
+			TopoDS_Shape replacement = MakeContainer(type);
+			replacement.Orientation(original.Orientation());
+			//
+			for (TopoDS_Iterator it{original}; it.More(); it.Next())
+			{
+				const TopoDS_Shape &child = it.Value();
+				if (myOrigins.IsBound(child))
+				{
+					TopoDS_Shape repl = myOrigins.Find(child);
+					if (BOPTools_AlgoTools::IsSplitToReverse(repl, child, myContext))
+					{
+						repl.Reverse();
+					}
+					//
+					builder.Add(replacement, repl);
+				}
+				else
+				{
+					builder.Add(replacement, child);
+				}
+			}
+			myOrigins.Bind(original, replacement);
+		}
+	}
+
+	// rebuild a touched compound (or compsolid) as a compound, those inside it
+	// must have been filled already
+	void
+	geomgluer2::FillCompound(const TopoDS_Shape &shape)
+	{
+		if (!IsTouched(shape))
+		{
+			return;
+		}
+		BRep_Builder builder;
+		TopoDS_Compound compound;
+		builder.MakeCompound(compound);
+		for (TopoDS_Iterator it{shape}; it.More(); it.Next())
+		{
+			const TopoDS_Shape &child = it.Value();
+			if (myOrigins.IsBound(child))
+			{
+				TopoDS_Shape repl = myOrigins.Find(child);
+				repl.Orientation(child.Orientation());
+				builder.Add(compound, repl);
+			}
+			else
+			{
+				builder.Add(compound, child);
+			}
+		}
+		myOrigins.Bind(shape, compound);
+	}
+
+	void
+	geomgluer2::FillCompounds(const Message_ProgressRange &range)
+	{
+		Message_ProgressScope scope{range, "fill compounds", 1};
+
+		// compsolids were marked when filled, and are rebuilt again here as
+		// compounds. inner compounds come first, and the argument itself is
+		// left to BuildResult
+		MarkTouched(TopAbs_COMPOUND);
+		for (int i = 1; i <= myContainers.Extent(); i++)
+		{
+			check_for_break(scope);
+
+			const TopoDS_Shape &shape = myContainers(i);
+			if (isCompoundShape(shape) && !shape.IsSame(myArgument))
+			{
+				FillCompound(shape);
+			}
+		}
+	}
+
+	TopoDS_Edge
+	geomgluer2::CopyEdge(TopoDS_Edge source)
+	{
+		source.Orientation(TopAbs_FORWARD);
+
+		TopoDS_Vertex v1, v2;
+		TopExp::Vertices(source, v1, v2);
+
+		double
+			p1 = BRep_Tool::Parameter(v1, source),
+			p2 = BRep_Tool::Parameter(v2, source);
+
+		if (myOrigins.IsBound(v1))
+		{
+			v1 = TopoDS::Vertex(myOrigins.Find(v1));
+		}
+		if (myOrigins.IsBound(v2))
+		{
+			v2 = TopoDS::Vertex(myOrigins.Find(v2));
+		}
+
+		v1.Orientation(TopAbs_FORWARD);
+		v2.Orientation(TopAbs_REVERSED);
+
+		TopoDS_Edge result;
+		BOPTools_AlgoTools::MakeSplitEdge(source, v1, p1, v2, p2, result);
+
+		if (BRep_Tool::Degenerated(source))
+		{
+			BRep_Builder builder;
+			builder.Degenerated(result, true);
+			builder.UpdateEdge(result, BRep_Tool::Tolerance(source));
+		}
+
+		return result;
+	}
+
+	TopoDS_Face
+	geomgluer2::CopyFace(TopoDS_Face source)
+	{
+		BRep_Builder builder;
+		source.Orientation(TopAbs_FORWARD);
+
+		//
+		TopoDS_Face result;
+		Standard_Boolean is_simple_shape;
+
+		{
+			TopLoc_Location loc;
+			auto surface = BRep_Tool::Surface(source, loc);
+			is_simple_shape = IsUPeriodic(surface);
+			builder.MakeFace(result, surface, loc, BRep_Tool::Tolerance(source));
+		}
+
+		Standard_Real aUMin, aUMax, aVMin, aVMax;
+		BRepTools::UVBounds(source, aUMin, aUMax, aVMin, aVMax);
+
+		// iterate over wires
+		for (TopoDS_Iterator it_wires{source}; it_wires.More(); it_wires.Next())
+		{
+			const TopoDS_Shape &orig_wire = it_wires.Value();
+
+			if (!myOrigins.IsBound(orig_wire))
+			{
+				builder.Add(result, orig_wire);
+				continue;
+			}
+
+			TopoDS_Shape wire = myOrigins.Find(orig_wire);
+			// clear contents
+			{
+				TopTools_ListOfShape edges;
+				for (TopoDS_Iterator it{wire}; it.More(); it.Next())
+				{
+					edges.Append(it.Value());
+				}
+				for (const TopoDS_Shape &edge : edges)
+				{
+					builder.Remove(wire, edge);
+				}
+			}
+
+			// refill contents
+			for (TopoDS_Iterator it_edges{orig_wire}; it_edges.More(); it_edges.Next())
+			{
+				const TopoDS_Edge &orig_edge = TopoDS::Edge(it_edges.Value());
+
+				TopoDS_Edge edge = orig_edge;
+				if (myOrigins.IsBound(orig_edge))
+				{
+					edge = TopoDS::Edge(myOrigins.Find(orig_edge));
+				}
+
+				if (BRep_Tool::Degenerated(edge))
+				{
+					edge.Orientation(orig_edge.Orientation());
+				}
+				else
+				{
+					TopoDS_Edge orig_fwd = orig_edge;
+					edge.Orientation(TopAbs_FORWARD);
+					orig_fwd.Orientation(TopAbs_FORWARD);
+					if (is_simple_shape)
+					{
+						RefinePCurveForEdgeOnFace(edge, source, aUMin, aUMax);
+					}
+					if (BuildPCurveForEdgeOnFace(orig_fwd, edge, source, myContext))
+					{
+						continue;
+					}
+					Standard_Boolean should_reverse = BOPTools_AlgoTools::IsSplitToReverse(
+						edge, orig_fwd, myContext);
+					edge.Orientation(orig_edge.Orientation());
+					if (should_reverse)
+						edge.Reverse();
+				}
+				builder.Add(wire, edge);
+			}
+			builder.Add(result, wire);
+		}
+		return result;
+	}
+
+	TopoDS_Shape
+	geomgluer2::CopyBRepShape(const TopoDS_Shape &source)
+	{
+		switch (source.ShapeType())
+		{
+		case TopAbs_EDGE:
+			return CopyEdge(TopoDS::Edge(source));
+		case TopAbs_FACE:
+			return CopyFace(TopoDS::Face(source));
+		default:
+			throw std::runtime_error("shape must be an EDGE for FACE");
+		}
+	}
+
+	TopoDS_Shape
+	geomgluer2::BuildResult()
+	{
+		BRep_Builder builder;
+		TopoDS_Compound compound;
+		builder.MakeCompound(compound);
+		//
+		for (TopoDS_Iterator it{myArgument}; it.More(); it.Next())
+		{
+			const TopoDS_Shape &aCX = it.Value();
+			if (myOrigins.IsBound(aCX))
+			{
+				builder.Add(compound, myOrigins.Find(aCX).Oriented(aCX.Orientation()));
+			}
+			else
+			{
+				builder.Add(compound, aCX);
+			}
+		}
+		TopoDS_Compound result;
+		builder.MakeCompound(result);
+		for (TopExp_Explorer it{compound, TopAbs_SOLID}; it.More(); it.Next())
+		{
+			builder.Add(result, it.Current());
+		}
+		return result;
+	}
+
+	// bounding boxes of each shape, inflated by the glue tolerance so that
+	// boxes of shapes which could share a vertex are guaranteed to overlap
+	std::vector<Bnd_Box>
+	inflated_bounding_boxes(
+		const std::vector<TopoDS_Shape> &shapes, Standard_Real tolerance)
+	{
+		std::vector<Bnd_Box> boxes(shapes.size());
+		OSD_Parallel::For(0, (int)shapes.size(), [&](int i)
+		{
+			boxes[i] = inflated_bounding_box(shapes[i], tolerance);
+		});
+		return boxes;
+	}
+
+	class disjoint_sets
+	{
+		std::vector<size_t> parent;
+
+	public:
+		disjoint_sets(size_t n) : parent(n)
+		{
+			std::iota(parent.begin(), parent.end(), 0);
+		}
+
+		size_t find(size_t i)
+		{
+			while (parent[i] != i)
+			{
+				parent[i] = parent[parent[i]];
+				i = parent[i];
+			}
+			return i;
+		}
+
+		void merge(size_t a, size_t b)
+		{
+			a = find(a);
+			b = find(b);
+			// keep the lowest index as the root so clusters come out in
+			// order of their first member
+			if (a < b)
+			{
+				parent[b] = a;
+			}
+			else if (b < a)
+			{
+				parent[a] = b;
+			}
+		}
+	};
+
+	// group shapes into clusters, where every shape in a cluster is linked to
+	// another by overlapping bounding boxes. members of each cluster, and the
+	// clusters themselves, are ordered by their position in the input
+	std::vector<std::vector<size_t>>
+	find_overlapping_clusters(
+		const std::vector<TopoDS_Shape> &shapes, Standard_Real tolerance)
+	{
+		const auto boxes = inflated_bounding_boxes(shapes, tolerance);
+
+		BoxTree tree;
+		{
+			BoxTreeFiller filler(tree);
+			for (size_t i = 0; i < boxes.size(); i++)
+			{
+				if (!boxes[i].IsVoid())
+				{
+					filler.Add((Standard_Integer)i, boxes[i]);
+				}
+			}
+			filler.Fill();
+		}
+
+		disjoint_sets sets{shapes.size()};
+		for (size_t i = 0; i < boxes.size(); i++)
+		{
+			if (boxes[i].IsVoid())
+			{
+				continue;
+			}
+			BoxSelector nearby{boxes[i]};
+			tree.Select(nearby);
+			for (auto idx : nearby.Indices())
+			{
+				sets.merge(i, (size_t)idx);
+			}
+		}
+
+		std::vector<std::vector<size_t>> clusters;
+		std::vector<size_t> cluster_of_root(shapes.size(), SIZE_MAX);
+		for (size_t i = 0; i < shapes.size(); i++)
+		{
+			const size_t root = sets.find(i);
+			if (cluster_of_root[root] == SIZE_MAX)
+			{
+				cluster_of_root[root] = clusters.size();
+				clusters.emplace_back();
+			}
+			clusters[cluster_of_root[root]].push_back(i);
+		}
+		return clusters;
+	}
+
+	// number of solids a shape will contribute to the gluer's result
+	size_t
+	count_solids(const TopoDS_Shape &shape)
+	{
+		size_t count = 0;
+		for (TopExp_Explorer ex{shape, TopAbs_SOLID}; ex.More(); ex.Next())
+		{
+			count += 1;
+		}
+		return count;
+	}
+
+	TopoDS_Shape
+	glue_cluster(
+		const std::vector<TopoDS_Shape> &shapes,
+		const std::vector<size_t> &members,
+		Standard_Real tolerance,
+		glue_stats *stats,
+		const Message_ProgressRange &range,
+		bool cross_solid_only = false)
+	{
+		BRep_Builder builder;
+		TopoDS_Compound compound;
+		builder.MakeCompound(compound);
+		for (const auto idx : members)
+		{
+			builder.Add(compound, shapes[idx]);
+		}
+
+		geomgluer2 gluer(compound, stats);
+		gluer.SetCrossSolidOnly(cross_solid_only);
+		return gluer.Perform(tolerance, range);
+	}
+
+	// the image of a child of the fuse, or a null shape with error set when it
+	// was removed or split. compounds have no history of their own, so are
+	// rebuilt from the images of their children when any of them changed
+	TopoDS_Shape
+	fused_image(
+		const Handle(BRepTools_History) &history, const TopoDS_Shape &shape,
+		size_t idx, std::string &error)
+	{
+		if (!history->IsSupportedType(shape))
+		{
+			std::vector<TopoDS_Shape> images;
+			bool changed = false;
+			for (TopoDS_Iterator it{shape}; it.More(); it.Next())
+			{
+				images.push_back(fused_image(history, it.Value(), idx, error));
+				if (images.back().IsNull())
+				{
+					return {};
+				}
+				changed = changed || !images.back().IsSame(it.Value());
+			}
+			if (!changed)
+			{
+				return shape;
+			}
+			BRep_Builder builder;
+			TopoDS_Compound compound;
+			builder.MakeCompound(compound);
+			for (const auto &image : images)
+			{
+				builder.Add(compound, image);
+			}
+			return compound;
+		}
+
+		if (history->IsRemoved(shape))
+		{
+			error = fmt::format("shape {} was removed by the fuse", idx);
+			return {};
+		}
+		const TopTools_ListOfShape &modified = history->Modified(shape);
+		if (modified.IsEmpty())
+		{
+			return shape;
+		}
+		if (modified.Extent() > 1)
+		{
+			// only happens when solids overlap, which gluing can't fix
+			error = fmt::format("shape {} was split into {} by overlapping shapes", idx, modified.Extent());
+			return {};
+		}
+		return modified.First();
+	}
+
+	// general fuse a cluster of solids, so faces that partly coincide are split
+	// along their common boundaries. returns the imprinted solids in the order
+	// of members, or an empty vector if the cluster has to be left as it was
+	std::vector<TopoDS_Shape>
+	imprint_cluster(
+		const std::vector<TopoDS_Shape> &shapes,
+		const std::vector<size_t> &members,
+		Standard_Real tolerance,
+		std::string &error,
+		const Message_ProgressRange &range,
+		bool run_parallel = false)
+	{
+		BOPAlgo_Builder builder;
+		for (const auto idx : members)
+		{
+			builder.AddArgument(shapes[idx]);
+		}
+		builder.SetFuzzyValue(tolerance);
+		builder.SetNonDestructive(Standard_True);
+		// unless asked for, clusters are already run concurrently
+		builder.SetRunParallel(run_parallel ? Standard_True : Standard_False);
+		builder.SetToFillHistory(Standard_True);
+
+		builder.Perform(range);
+
+		if (builder.HasError(STANDARD_TYPE(BOPAlgo_AlertUserBreak)))
+		{
+			throw glue_cancelled{"imprinting was cancelled"};
+		}
+		if (builder.HasErrors())
+		{
+			error = "general fuse failed";
+			return {};
+		}
+
+		const Handle(BRepTools_History) history = builder.History();
+		if (history.IsNull())
+		{
+			error = "general fuse kept no history";
+			return {};
+		}
+
+		std::vector<TopoDS_Shape> result;
+		result.reserve(members.size());
+		for (const auto idx : members)
+		{
+			result.push_back(fused_image(history, shapes[idx], idx, error));
+			if (result.back().IsNull())
+			{
+				return {};
+			}
+		}
+		return result;
+	}
+
+	// glue each cluster of shapes independently and concurrently, returning
+	// the resulting solids of each shape. clusters of one shape are passed
+	// through untouched. when failed is non-null, clusters that fail to glue
+	// are passed through too and their shapes appended to it, rather than
+	// exiting
+	std::vector<TopTools_ListOfShape>
+	glue_clusters_concurrently(
+		const std::vector<TopoDS_Shape> &children,
+		const std::vector<std::vector<size_t>> &clusters,
+		Standard_Real tolerance,
+		glue_stats *stats,
+		const Message_ProgressRange &progress,
+		std::vector<size_t> *failed_shapes = nullptr,
+		bool cross_solid_only = false)
+	{
+		std::vector<size_t> to_glue;
+		for (size_t i = 0; i < clusters.size(); i++)
+		{
+			if (clusters[i].size() > 1)
+			{
+				to_glue.push_back(i);
+			}
+		}
+
+		spdlog::info(
+			"partitioned {} shapes into {} clusters, {} need gluing",
+			children.size(), clusters.size(), to_glue.size());
+
+		// the gluer exits on failure, which we can't do from a worker thread so
+		// collect the errors and report them once everything has finished
+		std::vector<TopoDS_Shape> glued(clusters.size());
+		std::vector<std::string> errors(clusters.size());
+		std::vector<glue_stats> cluster_stats(stats ? clusters.size() : 0);
+
+		// progress ranges have to be made up front, each is then used by only one
+		// thread. clusters are weighted by their number of shapes
+		size_t num_to_glue = 0;
+		for (const auto cluster : to_glue)
+		{
+			num_to_glue += clusters[cluster].size();
+		}
+		Message_ProgressScope scope{
+			progress, "glue clusters", (Standard_Real)std::max<size_t>(num_to_glue, 1)};
+		std::vector<Message_ProgressRange> ranges;
+		for (const auto cluster : to_glue)
+		{
+			ranges.push_back(scope.Next((Standard_Real)clusters[cluster].size()));
+		}
+
+		std::atomic<bool> cancelled{false};
+		OSD_Parallel::For(0, (int)to_glue.size(), [&](int i)
+		{
+			const size_t cluster = to_glue[i];
+			try
+			{
+				glued[cluster] = glue_cluster(
+					children, clusters[cluster], tolerance,
+					stats ? &cluster_stats[cluster] : nullptr,
+					ranges[i], cross_solid_only);
+			}
+			catch (glue_cancelled &)
+			{
+				cancelled = true;
+			}
+			catch (std::exception &err)
+			{
+				errors[cluster] = err.what();
+			}
+		});
+
+		if (cancelled)
+		{
+			size_t num_done = 0;
+			for (const auto cluster : to_glue)
+			{
+				num_done += glued[cluster].IsNull() ? 0 : 1;
+			}
+			throw glue_cancelled{fmt::format(
+				"gluing was cancelled after {} of {} clusters", num_done, to_glue.size())};
+		}
+
+		bool failed = false;
+		for (const auto cluster : to_glue)
+		{
+			if (!errors[cluster].empty())
+			{
+				if (failed_shapes)
+				{
+					spdlog::warn(
+						"leaving cluster of {} shapes (starting at shape {}) unglued: {}",
+						clusters[cluster].size(), clusters[cluster].front(), errors[cluster]);
+					glued[cluster].Nullify();
+					failed_shapes->insert(
+						failed_shapes->end(), clusters[cluster].begin(), clusters[cluster].end());
+					continue;
+				}
+				spdlog::error(
+					"failed to glue cluster of {} shapes (starting at shape {}): {}",
+					clusters[cluster].size(), clusters[cluster].front(), errors[cluster]);
+				failed = true;
+			}
+		}
+		if (failed)
+		{
+			std::exit(1);
+		}
+
+		// phase times are summed over clusters, so can exceed the wall time
+		for (const auto &cs : cluster_stats)
+		{
+			stats->merge(cs);
+		}
+
+		// the gluer flattens its output to solids, in the order of its input.
+		// walk each cluster's output to recover the solids of each child
+		std::vector<TopTools_ListOfShape> solids_of_child(children.size());
+		for (size_t cluster = 0; cluster < clusters.size(); cluster++)
+		{
+			if (glued[cluster].IsNull())
+			{
+				// isolated shape or failed cluster, nothing was glued
+				for (const auto idx : clusters[cluster])
+				{
+					for (TopExp_Explorer ex{children[idx], TopAbs_SOLID}; ex.More(); ex.Next())
+					{
+						solids_of_child[idx].Append(ex.Current());
+					}
+				}
+				continue;
+			}
+
+			TopExp_Explorer ex{glued[cluster], TopAbs_SOLID};
+			for (const auto idx : clusters[cluster])
+			{
+				for (TopExp_Explorer orig{children[idx], TopAbs_SOLID}; orig.More(); orig.Next())
+				{
+					if (!ex.More())
+					{
+						spdlog::error("gluing cluster starting at shape {} lost solids", clusters[cluster].front());
+						std::exit(1);
+					}
+					solids_of_child[idx].Append(ex.Current());
+					ex.Next();
+				}
+			}
+		}
+
+		return solids_of_child;
+	}
+
+	TopoDS_Shape
+	make_compound_of_solids(const std::vector<TopTools_ListOfShape> &solids_of_child)
+	{
+		BRep_Builder builder;
+		TopoDS_Compound result;
+		builder.MakeCompound(result);
+		for (const auto &solids : solids_of_child)
+		{
+			for (const auto &solid : solids)
+			{
+				builder.Add(result, solid);
+			}
+		}
+		return result;
+	}
+
+	glue_group
+	make_glue_group(const TopTools_ListOfShape &shapes, const OwnerMap &owners)
+	{
+		glue_group group;
+		group.size = (size_t)shapes.Extent();
+		for (const auto &shape : shapes)
+		{
+			if (const std::vector<size_t> *found = owners.Seek(shape))
+			{
+				group.solids.insert(group.solids.end(), found->begin(), found->end());
+			}
+		}
+		std::sort(group.solids.begin(), group.solids.end());
+		group.solids.erase(
+			std::unique(group.solids.begin(), group.solids.end()),
+			group.solids.end());
+		return group;
+	}
+
+	// count the vertices (edges, faces) shared by several solids of a result,
+	// as groups glued into one, and the solids sharing them as glued
+	void
+	count_shared_shapes(const TopoDS_Shape &result, glue_stats &stats)
+	{
+		std::vector<TopoDS_Shape> solids;
+		for (TopExp_Explorer ex{result, TopAbs_SOLID}; ex.More(); ex.Next())
+		{
+			solids.push_back(ex.Current());
+		}
+
+		const auto count = [&](const TopAbs_ShapeEnum type, size_t &num_groups, size_t &num_glued)
+		{
+			OwnerMap owners;
+			map_owners(solids, type, owners);
+			for (OwnerMap::Iterator it{owners}; it.More(); it.Next())
+			{
+				if (it.Value().size() > 1)
+				{
+					num_groups += 1;
+					num_glued += it.Value().size();
+				}
+			}
+		};
+		count(TopAbs_VERTEX, stats.num_vertex_clusters, stats.num_glued_vertices);
+		count(TopAbs_EDGE, stats.num_edge_groups, stats.num_glued_edges);
+		count(TopAbs_FACE, stats.num_face_groups, stats.num_glued_faces);
+	}
+
+	// the detector's maps are keyed by address, sort so results are repeatable
+	void
+	sort_glue_groups(std::vector<glue_group> &groups)
+	{
+		std::sort(groups.begin(), groups.end(), [](const glue_group &a, const glue_group &b)
+				  { return std::tie(a.solids, a.size) < std::tie(b.solids, b.size); });
+	}
+
+	// a pair of vertices, as indicies into a TopTools_IndexedMapOfShape, and
+	// the smallest tolerance at which the gluer considers them coincident
+	struct vertex_pair
+	{
+		Standard_Integer a, b;
+		Standard_Real tolerance;
+	};
+
+	// all pairs of vertices coincident at the given tolerance, ordered by the
+	// tolerance they need. the tree is searched once, and smaller tolerances
+	// are handled by filtering the pairs
+	std::vector<vertex_pair>
+	find_vertex_pairs(const TopTools_IndexedMapOfShape &verticies, Standard_Real tolerance)
+	{
+		VertexTree bounding_tree;
+		fill_tree_with_verticies(bounding_tree, verticies, tolerance);
+
+		Handle(NCollection_IncAllocator) arena = new NCollection_IncAllocator;
+
+		std::vector<vertex_pair> pairs;
+		for (int i = 1; i <= verticies.Extent(); i++, arena->Reset(Standard_False))
+		{
+			const auto &vertex = TopoDS::Vertex(verticies(i));
+
+			VertexSelector nearby{vertex, tolerance, arena};
+			bounding_tree.Select(nearby);
+
+			for (auto idx : nearby.Indices())
+			{
+				if (idx <= i)
+				{
+					continue;
+				}
+				pairs.push_back({i, idx, vertex_pair_tolerance(vertex, TopoDS::Vertex(verticies(idx)))});
+			}
+		}
+
+		std::sort(pairs.begin(), pairs.end(), [](const vertex_pair &a, const vertex_pair &b)
+				  { return a.tolerance < b.tolerance; });
+		return pairs;
+	}
+
+	// clusters of vertices linked by pairs coincident at the tolerance, in the
+	// form gluedetector produces. vertices with nothing near them are left out,
+	// so aren't rebuilt
+	TopTools_DataMapOfShapeListOfShape
+	cluster_verticies(
+		const TopTools_IndexedMapOfShape &verticies,
+		const std::vector<vertex_pair> &pairs,
+		Standard_Real tolerance)
+	{
+		disjoint_sets sets((size_t)verticies.Extent() + 1);
+		for (const auto &pair : pairs)
+		{
+			if (pair.tolerance > tolerance)
+			{
+				break;
+			}
+			sets.merge((size_t)pair.a, (size_t)pair.b);
+		}
+
+		// roots are the lowest index in their cluster, so are seen first
+		TopTools_DataMapOfShapeListOfShape images;
+		for (int i = 1; i <= verticies.Extent(); i++)
+		{
+			const TopoDS_Shape &root = verticies((Standard_Integer)sets.find((size_t)i));
+			if (TopTools_ListOfShape *related = images.ChangeSeek(root))
+			{
+				related->Append(verticies(i));
+			}
+			else
+			{
+				images.Bound(root, TopTools_ListOfShape{})->Append(verticies(i));
+			}
+		}
+
+		TopTools_ListOfShape alone;
+		for (TopTools_DataMapOfShapeListOfShape::Iterator it{images}; it.More(); it.Next())
+		{
+			if (it.Value().Extent() < 2)
+			{
+				alone.Append(it.Key());
+			}
+		}
+		for (const TopoDS_Shape &vertex : alone)
+		{
+			images.UnBind(vertex);
+		}
+		return images;
+	}
+}
+
+void glue_stats::add_phase(const std::string &name, double seconds, size_t memory_bytes)
+{
+	for (auto &phase : phases)
+	{
+		if (phase.name == name)
+		{
+			phase.seconds += seconds;
+			phase.memory_bytes = std::max(phase.memory_bytes, memory_bytes);
+			return;
+		}
+	}
+	phases.push_back({name, seconds, memory_bytes});
+}
+
+void glue_stats::merge(const glue_stats &other)
+{
+	for (const auto &phase : other.phases)
+	{
+		add_phase(phase.name, phase.seconds, phase.memory_bytes);
+	}
+	peak_memory_bytes = std::max(peak_memory_bytes, other.peak_memory_bytes);
+
+	num_vertices += other.num_vertices;
+	num_vertex_clusters += other.num_vertex_clusters;
+	num_glued_vertices += other.num_glued_vertices;
+
+	num_edge_buckets += other.num_edge_buckets;
+	max_edge_bucket = std::max(max_edge_bucket, other.max_edge_bucket);
+	num_face_buckets += other.num_face_buckets;
+	max_face_bucket = std::max(max_face_bucket, other.max_face_bucket);
+
+	num_projections += other.num_projections;
+	num_analytic_checks += other.num_analytic_checks;
+
+	num_edge_groups += other.num_edge_groups;
+	num_glued_edges += other.num_glued_edges;
+	num_face_groups += other.num_face_groups;
+	num_glued_faces += other.num_glued_faces;
+
+	num_clusters += other.num_clusters;
+	num_imprinted += other.num_imprinted;
+	num_unglued += other.num_unglued;
+
+	mesh_solids.insert(mesh_solids.end(), other.mesh_solids.begin(), other.mesh_solids.end());
+	std::sort(mesh_solids.begin(), mesh_solids.end());
+
+	near_misses.insert(near_misses.end(), other.near_misses.begin(), other.near_misses.end());
+	std::stable_sort(near_misses.begin(), near_misses.end(), [](const glue_near_miss &a, const glue_near_miss &b)
+					 { return a.tolerance < b.tolerance; });
+}
+
+TopoDS_Shape
+salome_glue_shape(
+	const TopoDS_Shape &shape, Standard_Real tolerance,
+	glue_stats *stats, const Message_ProgressRange &progress,
+	bool cross_solid_only, Standard_Real near_miss_tolerance)
+{
+	try
+	{
+		geomgluer2 gluer(shape, stats);
+		gluer.SetCrossSolidOnly(cross_solid_only);
+		Message_ProgressScope scope{progress, "glue", 10};
+		TopoDS_Shape result = gluer.Perform(tolerance, scope.Next(9));
+		report_near_misses(result, tolerance, near_miss_tolerance, stats, scope.Next());
+		return result;
+	}
+
+	catch (glue_cancelled &)
+	{
+		throw;
+	}
+
+	catch (std::exception &err)
+	{
+
+		spdlog::error(
+			"failed to glue shapes: {}", err.what());
+		return {};
+	}
+}
+
+glue_detection
+salome_detect_glue(
+	const TopoDS_Shape &shape, Standard_Real tolerance,
+	glue_stats *stats, const Message_ProgressRange &progress)
+{
+	std::vector<TopoDS_Shape> children;
+	for (TopoDS_Iterator it{shape}; it.More(); it.Next())
+	{
+		children.push_back(it.Value());
+	}
+
+	TopTools_DataMapOfShapeListOfShape images;
+	try
+	{
+		Handle(IntTools_Context) context = new IntTools_Context{};
+		gluedetector detector{shape, tolerance, *context, stats, nullptr, progress};
+		detector.TakeImages(images);
+	}
+
+	catch (glue_cancelled &)
+	{
+		throw;
+	}
+
+	catch (std::exception &err)
+	{
+
+		spdlog::error(
+			"failed to detect coincident shapes: {}", err.what());
+		std::exit(1);
+	}
+
+	OwnerMap owners;
+	map_owners(children, TopAbs_VERTEX, owners);
+	map_owners(children, TopAbs_EDGE, owners);
+	map_owners(children, TopAbs_FACE, owners);
+
+	glue_detection result;
+	// the detector only keeps groups of two or more coincident shapes
+	for (TopTools_DataMapOfShapeListOfShape::Iterator it{images}; it.More(); it.Next())
+	{
+		switch (it.Key().ShapeType())
+		{
+		case TopAbs_VERTEX:
+			result.vertices.push_back(make_glue_group(it.Value(), owners));
+			break;
+		case TopAbs_EDGE:
+			result.edges.push_back(make_glue_group(it.Value(), owners));
+			break;
+		case TopAbs_FACE:
+			result.faces.push_back(make_glue_group(it.Value(), owners));
+			break;
+		default:
+			break;
+		}
+	}
+	sort_glue_groups(result.vertices);
+	sort_glue_groups(result.edges);
+	sort_glue_groups(result.faces);
+	return result;
+}
+
+TopoDS_Shape
+salome_glue_sweep(
+	const TopoDS_Shape &shape,
+	const std::vector<Standard_Real> &tolerances,
+	std::vector<glue_stats> &stats,
+	int glue_index,
+	const Message_ProgressRange &progress)
+{
+	if (tolerances.empty())
+	{
+		throw std::invalid_argument("no tolerances to sweep");
+	}
+	if (glue_index >= (int)tolerances.size())
+	{
+		throw std::out_of_range("index of the tolerance to glue at is out of range");
+	}
+
+	stats.assign(tolerances.size(), glue_stats{});
+
+	// largest first, its glued shapes are the candidates for the rest
+	std::vector<size_t> order(tolerances.size());
+	std::iota(order.begin(), order.end(), 0);
+	std::stable_sort(order.begin(), order.end(), [&](size_t a, size_t b)
+					 { return tolerances[a] > tolerances[b]; });
+
+	Message_ProgressScope scope{
+		progress, "sweep", (Standard_Real)tolerances.size() + (glue_index < 0 ? 0 : 1)};
+
+	try
+	{
+		Handle(IntTools_Context) context = new IntTools_Context{};
+
+		TopTools_IndexedMapOfShape verticies;
+		TopExp::MapShapes(shape, TopAbs_VERTEX, verticies);
+		if (verticies.IsEmpty())
+		{
+			throw std::runtime_error("no vertices in source shape");
+		}
+
+		std::vector<vertex_pair> pairs;
+		{
+			phase_timer timer{&stats[order.front()], "detect vertices"};
+			pairs = find_vertex_pairs(verticies, tolerances[order.front()]);
+		}
+
+		TopTools_MapOfShape candidates;
+		bool have_candidates = false;
+		TopTools_DataMapOfShapeListOfShape glue_images;
+
+		for (const auto idx : order)
+		{
+			check_for_break(scope);
+
+			glue_stats &tol_stats = stats[idx];
+
+			TopTools_DataMapOfShapeListOfShape vertex_images;
+			{
+				phase_timer timer{&tol_stats, "cluster vertices"};
+				vertex_images = cluster_verticies(verticies, pairs, tolerances[idx]);
+			}
+			tol_stats.num_vertices += (size_t)verticies.Extent();
+
+			// any edge or face could be glued at the largest tolerance
+			gluedetector detector{
+				shape, tolerances[idx], *context, &tol_stats,
+				vertex_images, have_candidates ? &candidates : nullptr, scope.Next()};
+
+			if (!have_candidates)
+			{
+				for (TopTools_DataMapOfShapeListOfShape::Iterator it{detector.Images()}; it.More(); it.Next())
+				{
+					if (it.Key().ShapeType() != TopAbs_VERTEX)
+					{
+						for (const TopoDS_Shape &glued : it.Value())
+						{
+							candidates.Add(glued);
+						}
+					}
+				}
+				have_candidates = true;
+			}
+
+			if ((int)idx == glue_index)
+			{
+				detector.TakeImages(glue_images);
+			}
+		}
+
+		if (glue_index < 0)
+		{
+			return {};
+		}
+
+		geomgluer2 gluer(shape, &stats[(size_t)glue_index]);
+		return gluer.Perform(tolerances[(size_t)glue_index], std::move(glue_images), scope.Next());
+	}
+
+	catch (glue_cancelled &)
+	{
+		throw;
+	}
+
+	catch (std::exception &err)
+	{
+
+		spdlog::error(
+			"failed to sweep glue tolerances: {}", err.what());
+		std::exit(1);
+	}
+}
+
+TopoDS_Shape
+salome_glue_shape_partitioned(
+	const TopoDS_Shape &shape, Standard_Real tolerance,
+	glue_stats *stats, const Message_ProgressRange &progress,
+	bool cross_solid_only, Standard_Real near_miss_tolerance)
+{
+	std::vector<TopoDS_Shape> children;
+	for (TopoDS_Iterator it{shape}; it.More(); it.Next())
+	{
+		children.push_back(it.Value());
+	}
+
+	std::vector<std::vector<size_t>> clusters;
+	{
+		phase_timer timer{stats, "partition"};
+		clusters = find_overlapping_clusters(children, tolerance);
+	}
+
+	// near misses are searched for over the whole result, so pairs between
+	// clusters are found too
+	Message_ProgressScope scope{progress, "glue", 10};
+	TopoDS_Shape result = make_compound_of_solids(glue_clusters_concurrently(
+		children, clusters, tolerance, stats, scope.Next(9), nullptr, cross_solid_only));
+	report_near_misses(result, tolerance, near_miss_tolerance, stats, scope.Next());
+	return result;
+}
+
+TopoDS_Shape
+salome_glue_shape_with_fallback(
+	const TopoDS_Shape &shape, const std::vector<size_t> &mesh_children,
+	bool fallback_on_failure, Standard_Real tolerance,
+	glue_stats *stats, const Message_ProgressRange &progress,
+	bool cross_solid_only, Standard_Real near_miss_tolerance)
+{
+	std::vector<TopoDS_Shape> children;
+	for (TopoDS_Iterator it{shape}; it.More(); it.Next())
+	{
+		children.push_back(it.Value());
+	}
+
+	std::vector<bool> in_mesh(children.size(), false);
+	for (const auto idx : mesh_children)
+	{
+		if (idx >= children.size())
+		{
+			spdlog::error("shape {} selected for mesh merging, but there are only {}", idx, children.size());
+			std::exit(1);
+		}
+		in_mesh[idx] = true;
+	}
+
+	// clusters holding a selected shape are split into single shapes, which
+	// are passed through unglued
+	std::vector<size_t> unglued;
+	std::vector<std::vector<size_t>> clusters;
+	{
+		phase_timer timer{stats, "partition"};
+		for (auto &cluster : find_overlapping_clusters(children, tolerance))
+		{
+			const bool skip = std::any_of(
+				cluster.begin(), cluster.end(), [&](size_t idx) { return in_mesh[idx]; });
+			if (!skip || cluster.size() == 1)
+			{
+				clusters.push_back(std::move(cluster));
+				continue;
+			}
+			for (const auto idx : cluster)
+			{
+				unglued.push_back(idx);
+				clusters.push_back({idx});
+			}
+		}
+	}
+
+	Message_ProgressScope scope{progress, "glue", 10};
+	auto solids_of_child = glue_clusters_concurrently(
+		children, clusters, tolerance, stats, scope.Next(9),
+		fallback_on_failure ? &unglued : nullptr, cross_solid_only);
+
+	std::sort(unglued.begin(), unglued.end());
+	spdlog::info("{} shapes left for merging in mesh space", unglued.size());
+	if (stats)
+	{
+		stats->mesh_solids.insert(stats->mesh_solids.end(), unglued.begin(), unglued.end());
+		std::sort(stats->mesh_solids.begin(), stats->mesh_solids.end());
+	}
+
+	TopoDS_Shape result = make_compound_of_solids(solids_of_child);
+	report_near_misses(result, tolerance, near_miss_tolerance, stats, scope.Next());
+	return result;
+}
+
+TopoDS_Shape
+salome_glue_shape_grouped(
+	const TopoDS_Shape &shape, const std::vector<size_t> &groups, Standard_Real tolerance,
+	glue_stats *stats, const Message_ProgressRange &progress)
+{
+	std::vector<TopoDS_Shape> children;
+	for (TopoDS_Iterator it{shape}; it.More(); it.Next())
+	{
+		children.push_back(it.Value());
+	}
+	if (groups.size() != children.size())
+	{
+		spdlog::error("{} groups given for {} shapes", groups.size(), children.size());
+		std::exit(1);
+	}
+
+	// members of each group, in order of their first member
+	std::vector<std::vector<size_t>> members;
+	// shapes near a shape of another group
+	std::vector<bool> on_boundary(children.size(), false);
+	{
+		phase_timer timer{stats, "partition"};
+
+		// position in members of each group id
+		std::unordered_map<size_t, size_t> member_of_group;
+		for (size_t i = 0; i < children.size(); i++)
+		{
+			const auto inserted = member_of_group.emplace(groups[i], members.size());
+			if (inserted.second)
+			{
+				members.push_back({i});
+			}
+			else
+			{
+				members[inserted.first->second].push_back(i);
+			}
+		}
 
-		for (TopExp_Explorer ex{myArgument, type}; ex.More(); ex.Next())
+		const auto boxes = inflated_bounding_boxes(children, tolerance);
+		BoxTree tree;
 		{
-			const TopoDS_Shape &original = ex.Current();
-			if (!processed.Add(original))
+			BoxTreeFiller filler(tree);
+			for (size_t i = 0; i < boxes.size(); i++)
 			{
-				// already processed, ignore
-				continue;
+				if (!boxes[i].IsVoid())
+				{
+					filler.Add((Standard_Integer)i, boxes[i]);
+				}
 			}
-			if (!is_bound_in_origins(original))
+			filler.Fill();
+		}
+		for (size_t i = 0; i < boxes.size(); i++)
+		{
+			if (boxes[i].IsVoid())
 			{
 				continue;
 			}
-			//
-			TopoDS_Shape replacement = MakeContainer(type);
-			replacement.Orientation(original.Orientation());
-			//
-			for (TopoDS_Iterator it{original}; it.More(); it.Next())
+			BoxSelector nearby{boxes[i]};
+			tree.Select(nearby);
+			for (const auto idx : nearby.Indices())
 			{
-				const TopoDS_Shape &child = it.Value();
-				if (myOrigins.IsBound(child))
-				{
-					TopoDS_Shape repl = myOrigins.Find(child);
-					if (BOPTools_AlgoTools::IsSplitToReverse(repl, child, myContext))
-					{
-						repl.Reverse();
-					}
-					//
-					builder.Add(replacement, repl);
-				}
-				else
+				if (groups[(size_t)idx] != groups[i])
 				{
-					builder.Add(replacement, child);
+					on_boundary[i] = true;
+					break;
 				}
 			}
-			myOrigins.Bind(original, replacement);
 		}
 	}
 
-	void
-	geomgluer2::FillCompound(const TopoDS_Shape &shape)
+	// the shapes of each group are glued to each other, then the shapes on
+	// the boundaries of groups are glued onto their already glued neighbours
+	Message_ProgressScope scope{progress, "glue groups", 2};
+
+	auto solids_of_child = glue_clusters_concurrently(
+		children, members, tolerance, stats, scope.Next());
+
+	BRep_Builder builder;
+	TopoDS_Compound boundary, interior;
+	builder.MakeCompound(boundary);
+	builder.MakeCompound(interior);
+	size_t num_boundary = 0;
+	for (size_t i = 0; i < children.size(); i++)
 	{
-		if (!is_bound_in_origins(shape))
+		TopoDS_Compound &dest = on_boundary[i] ? boundary : interior;
+		for (const auto &solid : solids_of_child[i])
 		{
-			return;
+			builder.Add(dest, solid);
 		}
-		BRep_Builder builder;
-		TopoDS_Compound compound;
-		builder.MakeCompound(compound);
-		for (TopoDS_Iterator it{shape}; it.More(); it.Next())
+		num_boundary += on_boundary[i] ? 1 : 0;
+	}
+
+	spdlog::info(
+		"glued {} groups, gluing {} of {} shapes across group boundaries",
+		members.size(), num_boundary, children.size());
+
+	if (num_boundary == 0)
+	{
+		return make_compound_of_solids(solids_of_child);
+	}
+
+	// shared sub-shapes of the interior are fixed, so gluing the boundary
+	// keeps what was glued within groups. boundary shapes are searched whole,
+	// as the gluer has no way to start from the sub-shapes groups share
+	const auto glued = salome_glue_shape_onto(boundary, interior, tolerance, stats, scope.Next());
+
+	TopExp_Explorer ex{glued, TopAbs_SOLID};
+	for (size_t i = 0; i < children.size(); i++)
+	{
+		if (!on_boundary[i])
 		{
-			const TopoDS_Shape &child = it.Value();
-			if (isCompoundShape(child))
-			{
-				FillCompound(child);
-			}
-			if (myOrigins.IsBound(child))
-			{
-				TopoDS_Shape repl = myOrigins.Find(child);
-				repl.Orientation(child.Orientation());
-				builder.Add(compound, repl);
-			}
-			else
+			continue;
+		}
+		for (auto &solid : solids_of_child[i])
+		{
+			if (!ex.More())
 			{
-				builder.Add(compound, child);
+				spdlog::error("gluing across groups lost solids");
+				std::exit(1);
 			}
+			solid = ex.Current();
+			ex.Next();
 		}
-		myOrigins.Bind(shape, compound);
 	}
 
-	void
-	geomgluer2::FillCompounds()
+	return make_compound_of_solids(solids_of_child);
+}
+
+TopoDS_Shape
+salome_imprint_shape(
+	const TopoDS_Shape &shape, Standard_Real tolerance,
+	glue_stats *stats, const Message_ProgressRange &progress)
+{
+	std::vector<TopoDS_Shape> children;
+	for (TopoDS_Iterator it{shape}; it.More(); it.Next())
 	{
-		for (TopoDS_Iterator it{myArgument}; it.More(); it.Next())
+		children.push_back(it.Value());
+	}
+
+	std::vector<std::vector<size_t>> clusters;
+	{
+		phase_timer timer{stats, "partition"};
+		clusters = find_overlapping_clusters(children, tolerance);
+	}
+
+	std::vector<size_t> to_imprint;
+	size_t num_to_imprint = 0;
+	for (size_t i = 0; i < clusters.size(); i++)
+	{
+		if (clusters[i].size() > 1)
 		{
-			const TopoDS_Shape &shape = it.Value();
-			if (isCompoundShape(shape))
-			{
-				FillCompound(shape);
-			}
+			to_imprint.push_back(i);
+			num_to_imprint += clusters[i].size();
 		}
 	}
 
-	TopoDS_Edge
-	geomgluer2::CopyEdge(TopoDS_Edge source)
-	{
-		source.Orientation(TopAbs_FORWARD);
+	spdlog::info("imprinting {} clusters of touching shapes", to_imprint.size());
 
-		TopoDS_Vertex v1, v2;
-		TopExp::Vertices(source, v1, v2);
+	phase_timer timer{stats, "imprint"};
 
-		double
-			p1 = BRep_Tool::Parameter(v1, source),
-			p2 = BRep_Tool::Parameter(v2, source);
+	Message_ProgressScope scope{
+		progress, "imprint clusters", (Standard_Real)std::max<size_t>(num_to_imprint, 1)};
+	std::vector<Message_ProgressRange> ranges;
+	for (const auto cluster : to_imprint)
+	{
+		ranges.push_back(scope.Next((Standard_Real)clusters[cluster].size()));
+	}
 
-		if (myOrigins.IsBound(v1))
+	std::vector<std::vector<TopoDS_Shape>> imprinted(clusters.size());
+	std::vector<std::string> errors(clusters.size());
+	std::atomic<bool> cancelled{false};
+	OSD_Parallel::For(0, (int)to_imprint.size(), [&](int i)
+	{
+		const size_t cluster = to_imprint[i];
+		try
 		{
-			v1 = TopoDS::Vertex(myOrigins.Find(v1));
+			imprinted[cluster] = imprint_cluster(
+				children, clusters[cluster], tolerance, errors[cluster], ranges[i]);
 		}
-		if (myOrigins.IsBound(v2))
+		catch (glue_cancelled &)
 		{
-			v2 = TopoDS::Vertex(myOrigins.Find(v2));
+			cancelled = true;
 		}
-
-		v1.Orientation(TopAbs_FORWARD);
-		v2.Orientation(TopAbs_REVERSED);
-
-		TopoDS_Edge result;
-		BOPTools_AlgoTools::MakeSplitEdge(source, v1, p1, v2, p2, result);
-
-		if (BRep_Tool::Degenerated(source))
+		catch (std::exception &err)
 		{
-			BRep_Builder builder;
-			builder.Degenerated(result, true);
-			builder.UpdateEdge(result, BRep_Tool::Tolerance(source));
+			errors[cluster] = err.what();
 		}
+	});
 
-		return result;
+	if (cancelled)
+	{
+		throw glue_cancelled{"imprinting was cancelled"};
 	}
 
-	TopoDS_Face
-	geomgluer2::CopyFace(TopoDS_Face source)
+	// a cluster that can't be imprinted is still glued where its faces match
+	size_t num_imprinted = 0;
+	for (const auto cluster : to_imprint)
 	{
-		BRep_Builder builder;
-		source.Orientation(TopAbs_FORWARD);
-
-		//
-		TopoDS_Face result;
-		Standard_Boolean is_simple_shape;
-
+		if (imprinted[cluster].empty())
 		{
-			TopLoc_Location loc;
-			auto surface = BRep_Tool::Surface(source, loc);
-			is_simple_shape = IsUPeriodic(surface);
-			builder.MakeFace(result, surface, loc, BRep_Tool::Tolerance(source));
+			spdlog::warn(
+				"left cluster of {} shapes (starting at shape {}) unimprinted: {}",
+				clusters[cluster].size(), clusters[cluster].front(), errors[cluster]);
+			continue;
 		}
-
-		Standard_Real aUMin, aUMax, aVMin, aVMax;
-		BRepTools::UVBounds(source, aUMin, aUMax, aVMin, aVMax);
-
-		// iterate over wires
-		for (TopoDS_Iterator it_wires{source}; it_wires.More(); it_wires.Next())
+		const auto &members = clusters[cluster];
+		for (size_t i = 0; i < members.size(); i++)
 		{
-			const TopoDS_Shape &orig_wire = it_wires.Value();
-
-			if (!myOrigins.IsBound(orig_wire))
+			if (!imprinted[cluster][i].IsSame(children[members[i]]))
 			{
-				builder.Add(result, orig_wire);
-				continue;
+				children[members[i]] = imprinted[cluster][i];
+				num_imprinted += 1;
 			}
+		}
+	}
 
-			TopoDS_Shape wire = myOrigins.Find(orig_wire);
-			// clear contents
-			{
-				TopTools_ListOfShape edges;
-				for (TopoDS_Iterator it{wire}; it.More(); it.Next())
-				{
-					edges.Append(it.Value());
-				}
-				for (const TopoDS_Shape &edge : edges)
-				{
-					builder.Remove(wire, edge);
-				}
-			}
+	if (stats)
+	{
+		stats->num_imprinted += num_imprinted;
+	}
 
-			// refill contents
-			for (TopoDS_Iterator it_edges{orig_wire}; it_edges.More(); it_edges.Next())
-			{
-				const TopoDS_Edge &orig_edge = TopoDS::Edge(it_edges.Value());
+	BRep_Builder builder;
+	TopoDS_Compound result;
+	builder.MakeCompound(result);
+	for (const auto &child : children)
+	{
+		builder.Add(result, child);
+	}
+	return result;
+}
 
-				TopoDS_Edge edge = orig_edge;
-				if (myOrigins.IsBound(orig_edge))
-				{
-					edge = TopoDS::Edge(myOrigins.Find(orig_edge));
-				}
+TopoDS_Shape
+fuse_glue_shape(
+	const TopoDS_Shape &shape, Standard_Real tolerance,
+	glue_stats *stats, const Message_ProgressRange &progress)
+{
+	std::vector<TopoDS_Shape> children;
+	for (TopoDS_Iterator it{shape}; it.More(); it.Next())
+	{
+		children.push_back(it.Value());
+	}
+	if (stats)
+	{
+		TopTools_IndexedMapOfShape verticies;
+		TopExp::MapShapes(shape, TopAbs_VERTEX, verticies);
+		stats->num_vertices += (size_t)verticies.Extent();
+		stats->num_clusters += 1;
+	}
 
-				if (BRep_Tool::Degenerated(edge))
-				{
-					edge.Orientation(orig_edge.Orientation());
-				}
-				else
-				{
-					TopoDS_Edge orig_fwd = orig_edge;
-					edge.Orientation(TopAbs_FORWARD);
-					orig_fwd.Orientation(TopAbs_FORWARD);
-					if (is_simple_shape)
-					{
-						RefinePCurveForEdgeOnFace(edge, source, aUMin, aUMax);
-					}
-					if (BuildPCurveForEdgeOnFace(orig_fwd, edge, source, myContext))
-					{
-						continue;
-					}
-					Standard_Boolean should_reverse = BOPTools_AlgoTools::IsSplitToReverse(
-						edge, orig_fwd, myContext);
-					edge.Orientation(orig_edge.Orientation());
-					if (should_reverse)
-						edge.Reverse();
-				}
-				builder.Add(wire, edge);
-			}
-			builder.Add(result, wire);
-		}
-		return result;
+	std::vector<size_t> members(children.size());
+	std::iota(members.begin(), members.end(), 0);
+
+	std::vector<TopoDS_Shape> fused;
+	std::string error;
+	{
+		phase_timer timer{stats, "general fuse"};
+		// one fuse over everything, left to OCCT to run in parallel
+		fused = imprint_cluster(children, members, tolerance, error, progress, true);
+	}
+	if (fused.empty())
+	{
+		spdlog::error("failed to fuse shapes: {}", error);
+		return {};
 	}
 
-	TopoDS_Shape
-	geomgluer2::CopyBRepShape(const TopoDS_Shape &source)
+	// the same flattening to solids as the gluer
+	BRep_Builder builder;
+	TopoDS_Compound result;
+	builder.MakeCompound(result);
+	for (const auto &child : fused)
 	{
-		switch (source.ShapeType())
+		for (TopExp_Explorer ex{child, TopAbs_SOLID}; ex.More(); ex.Next())
 		{
-		case TopAbs_EDGE:
-			return CopyEdge(TopoDS::Edge(source));
-		case TopAbs_FACE:
-			return CopyFace(TopoDS::Face(source));
-		default:
-			throw std::runtime_error("shape must be an EDGE for FACE");
+			builder.Add(result, ex.Current());
 		}
 	}
 
-	TopoDS_Shape
-	geomgluer2::BuildResult()
+	if (stats)
 	{
-		BRep_Builder builder;
-		TopoDS_Compound compound;
-		builder.MakeCompound(compound);
-		//
-		for (TopoDS_Iterator it{myArgument}; it.More(); it.Next())
+		phase_timer timer{stats, "count shared"};
+		count_shared_shapes(result, *stats);
+	}
+	return result;
+}
+
+TopoDS_Shape
+salome_glue_shape_onto(
+	const TopoDS_Shape &shape, const TopoDS_Shape &fixed, Standard_Real tolerance,
+	glue_stats *stats, const Message_ProgressRange &progress)
+{
+	std::vector<TopoDS_Shape> children, context;
+	for (TopoDS_Iterator it{shape}; it.More(); it.Next())
+	{
+		children.push_back(it.Value());
+	}
+	for (TopoDS_Iterator it{fixed}; it.More(); it.Next())
+	{
+		context.push_back(it.Value());
+	}
+
+	// only shapes close to one of the inputs can take part in gluing
+	const auto boxes = inflated_bounding_boxes(children, tolerance);
+	const auto context_boxes = inflated_bounding_boxes(context, tolerance);
+
+	BoxTree tree;
+	{
+		BoxTreeFiller filler(tree);
+		for (size_t i = 0; i < boxes.size(); i++)
 		{
-			const TopoDS_Shape &aCX = it.Value();
-			if (myOrigins.IsBound(aCX))
+			if (!boxes[i].IsVoid())
 			{
-				builder.Add(compound, myOrigins.Find(aCX).Oriented(aCX.Orientation()));
-			}
-			else
-			{
-				builder.Add(compound, aCX);
+				filler.Add((Standard_Integer)i, boxes[i]);
 			}
 		}
-		TopoDS_Compound result;
-		builder.MakeCompound(result);
-		for (TopExp_Explorer it{compound, TopAbs_SOLID}; it.More(); it.Next())
+		filler.Fill();
+	}
+
+	BRep_Builder builder;
+	TopoDS_Compound compound, neighbours;
+	builder.MakeCompound(compound);
+	builder.MakeCompound(neighbours);
+
+	size_t num_solids = 0;
+	for (const auto &child : children)
+	{
+		builder.Add(compound, child);
+		num_solids += count_solids(child);
+	}
+
+	size_t num_neighbours = 0;
+	for (size_t i = 0; i < context.size(); i++)
+	{
+		if (context_boxes[i].IsVoid())
 		{
-			builder.Add(result, it.Current());
+			continue;
+		}
+		BoxSelector nearby{context_boxes[i]};
+		if (tree.Select(nearby) > 0)
+		{
+			builder.Add(compound, context[i]);
+			builder.Add(neighbours, context[i]);
+			num_neighbours += 1;
 		}
-		return result;
 	}
-}
 
-TopoDS_Shape
-salome_glue_shape(const TopoDS_Shape &shape, Standard_Real tolerance)
-{
+	spdlog::info(
+		"gluing {} shapes onto {} of {} fixed shapes",
+		children.size(), num_neighbours, context.size());
+
+	TopoDS_Shape glued;
 	try
 	{
-		geomgluer2 gluer(shape);
-		return gluer.Perform(tolerance);
+		geomgluer2 gluer(compound, stats);
+		gluer.SetFixed(neighbours);
+		glued = gluer.Perform(tolerance, progress);
+	}
+
+	catch (glue_cancelled &)
+	{
+		throw;
 	}
 
 	catch (std::exception &err)
@@ -1353,4 +4139,19 @@ salome_glue_shape(const TopoDS_Shape &shape, Standard_Real tolerance)
 			"failed to glue shapes: {}", err.what());
 		std::exit(1);
 	}
+
+	// our shapes were added first, so their solids lead the result
+	TopoDS_Compound result;
+	builder.MakeCompound(result);
+	TopExp_Explorer ex{glued, TopAbs_SOLID};
+	for (size_t i = 0; i < num_solids; i++, ex.Next())
+	{
+		if (!ex.More())
+		{
+			spdlog::error("gluing lost solids, expected {} got {}", num_solids, i);
+			std::exit(1);
+		}
+		builder.Add(result, ex.Current());
+	}
+	return result;
 }
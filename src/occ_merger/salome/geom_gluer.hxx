@@ -1,4 +1,234 @@
+#ifndef GEOM_GLUER_HXX
+#define GEOM_GLUER_HXX
+
+#include <array>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include <Message_ProgressRange.hxx>
 #include <TopoDS_Shape.hxx>
 
+// wall time spent in one phase of the gluer
+struct glue_phase
+{
+	std::string name;
+	double seconds;
+	// largest resident memory of the process seen at the end of the phase
+	size_t memory_bytes;
+};
+
+// a pair of vertices (edges, faces) further apart than the gluing tolerance,
+// but within the bound asked for
+struct glue_near_miss
+{
+	// "vertex", "edge" or "face"
+	std::string type;
+
+	// the smallest tolerance that would glue the pair. for edges and faces
+	// this is measured as the coincidence check does, from a point of each
+	// to the other, taking the larger of the two
+	double tolerance = 0;
+
+	// indices of the children of the glued shape containing each side, sorted
+	std::vector<size_t> solids_a, solids_b;
+
+	// the vertices, or the point on edge (face) a and its projection onto b
+	std::array<double, 3> position_a{}, position_b{};
+};
+
+// instrumentation of the gluer. when several clusters are glued, times and
+// counts are summed over them
+struct glue_stats
+{
+	// in the order they first ran
+	std::vector<glue_phase> phases;
+
+	// distinct vertices, clusters of more than one coincident vertex and the
+	// number of vertices in those clusters
+	size_t num_vertices = 0;
+	size_t num_vertex_clusters = 0;
+	size_t num_glued_vertices = 0;
+
+	// buckets of edges (faces) sharing the same glued vertices (edges), these
+	// are the candidates checked for geometric coincidence
+	size_t num_edge_buckets = 0, max_edge_bucket = 0;
+	size_t num_face_buckets = 0, max_face_bucket = 0;
+
+	// points projected onto edges and faces during the coincidence checks,
+	// and checks of lines, circles, planes and cylinders done in closed form
+	size_t num_projections = 0;
+	size_t num_analytic_checks = 0;
+
+	// groups of coincident edges (faces), and the number of edges (faces) in
+	// those groups
+	size_t num_edge_groups = 0, num_glued_edges = 0;
+	size_t num_face_groups = 0, num_glued_faces = 0;
+
+	// number of independent problems the gluer solved
+	size_t num_clusters = 0;
+
+	// solids whose faces were split by imprinting
+	size_t num_imprinted = 0;
+
+	// vertices, edges and faces coincident with a fixed shape but left
+	// unglued, as the fixed vertex they'd be glued onto doesn't cover them.
+	// see salome_glue_shape_onto
+	size_t num_unglued = 0;
+
+	// high-water mark of the process's resident memory, as seen at the end
+	// of each phase. zero when the platform doesn't report it
+	size_t peak_memory_bytes = 0;
+
+	// children of the glued shape left unglued, to be made conformal in mesh
+	// space when faceting instead. sorted
+	std::vector<size_t> mesh_solids;
+
+	// pairs that were close but not glued, when asked for. ordered by the
+	// tolerance they need
+	std::vector<glue_near_miss> near_misses;
+
+	void add_phase(const std::string &name, double seconds, size_t memory_bytes = 0);
+	void merge(const glue_stats &other);
+};
+
+// coincident vertices (edges, faces) that gluing would merge into one
+struct glue_group
+{
+	// number of vertices (edges, faces) in the group
+	size_t size = 0;
+
+	// indices of the children of the glued shape containing them, sorted
+	std::vector<size_t> solids;
+};
+
+// what would be glued, without building the result
+struct glue_detection
+{
+	std::vector<glue_group> vertices, edges, faces;
+};
+
+// thrown when the progress indicator passed to the gluer requests a break,
+// e.g. because the user cancelled or a time limit was reached
+class glue_cancelled : public std::runtime_error
+{
+public:
+	using std::runtime_error::runtime_error;
+};
+
+// stats are collected when non-null. progress is reported through the range,
+// and a break requested through it raises glue_cancelled, while a failure to
+// glue is logged and gives a null shape. with cross_solid_only, only vertices, edges and faces of different solids are
+// glued: pairs from one solid, and solids with no other within tolerance, are
+// skipped before any search or projection. when near_miss_tolerance is larger
+// than tolerance and stats are collected, the result is searched once more,
+// out to near_miss_tolerance, for pairs of different solids that weren't
+// glued and don't already share a vertex, which are listed in
+// stats->near_misses. the search is the last tenth of the progress range, so
+// it can be cancelled or run out of time like the gluing
+
+TopoDS_Shape
+salome_glue_shape(
+	const TopoDS_Shape &shape, Standard_Real tolerance,
+	glue_stats *stats = nullptr,
+	const Message_ProgressRange &progress = Message_ProgressRange(),
+	bool cross_solid_only = false,
+	Standard_Real near_miss_tolerance = 0);
+
+// run only the detection phases of salome_glue_shape, reporting the groups of
+// coincident sub-shapes it would glue
+glue_detection
+salome_detect_glue(
+	const TopoDS_Shape &shape, Standard_Real tolerance,
+	glue_stats *stats = nullptr,
+	const Message_ProgressRange &progress = Message_ProgressRange());
+
+// detect what would be glued at each of the tolerances, sharing the work of
+// finding nearby vertices between them. only shapes glued at the largest
+// tolerance are considered at the others. stats are per tolerance, and when
+// glue_index is not negative the shape glued at tolerances[glue_index] is
+// returned, otherwise a null shape
+TopoDS_Shape
+salome_glue_sweep(
+	const TopoDS_Shape &shape,
+	const std::vector<Standard_Real> &tolerances,
+	std::vector<glue_stats> &stats,
+	int glue_index = -1,
+	const Message_ProgressRange &progress = Message_ProgressRange());
+
+// glue each cluster of shapes with overlapping (tolerance inflated) bounding
+// boxes independently and concurrently. shapes not near any other are passed
+// through untouched. the solids in the result are in the same order as
+// salome_glue_shape would produce. near misses are searched for over the
+// whole result, so those between clusters are found as well
+TopoDS_Shape
+salome_glue_shape_partitioned(
+	const TopoDS_Shape &shape, Standard_Real tolerance,
+	glue_stats *stats = nullptr,
+	const Message_ProgressRange &progress = Message_ProgressRange(),
+	bool cross_solid_only = false,
+	Standard_Real near_miss_tolerance = 0);
+
+// as salome_glue_shape_partitioned, but clusters holding any of mesh_children,
+// and when fallback_on_failure clusters that fail to glue, are passed through
+// unglued rather than glued (or exiting). their children are listed in
+// stats->mesh_solids, for the faceter to make conformal in mesh space
+TopoDS_Shape
+salome_glue_shape_with_fallback(
+	const TopoDS_Shape &shape, const std::vector<size_t> &mesh_children,
+	bool fallback_on_failure, Standard_Real tolerance,
+	glue_stats *stats = nullptr,
+	const Message_ProgressRange &progress = Message_ProgressRange(),
+	bool cross_solid_only = false,
+	Standard_Real near_miss_tolerance = 0);
+
+// glue the shapes of each group (e.g. an assembly's components) to each other,
+// concurrently, then glue the shapes near another group onto their glued
+// neighbours. groups holds the group of each child of `shape`. the solids in
+// the result are in the same order as salome_glue_shape would produce. the
+// second pass searches the whole of each boundary shape and its neighbours,
+// not just the sub-shapes they share, so it costs as much as gluing them
+// alone would
+TopoDS_Shape
+salome_glue_shape_grouped(
+	const TopoDS_Shape &shape, const std::vector<size_t> &groups, Standard_Real tolerance,
+	glue_stats *stats = nullptr,
+	const Message_ProgressRange &progress = Message_ProgressRange());
+
+// general fuse each cluster of shapes with overlapping (tolerance inflated)
+// bounding boxes, concurrently, so faces in partial contact are split into
+// matching pieces the gluer can then merge. clusters that fail, or whose
+// solids overlap, are left as they were. the children of the result
+// correspond one to one with those of `shape`
 TopoDS_Shape
-salome_glue_shape(const TopoDS_Shape &shape, Standard_Real tolerance);
+salome_imprint_shape(
+	const TopoDS_Shape &shape, Standard_Real tolerance,
+	glue_stats *stats = nullptr,
+	const Message_ProgressRange &progress = Message_ProgressRange());
+
+// an alternative to the gluer, general fuse all the children of `shape` at
+// once with tolerance as the fuzzy value, so coincident and partly coincident
+// sub-shapes come out shared. OCCT runs the fuse in parallel. the solids in
+// the result are in the same order as salome_glue_shape would produce. the
+// glued counts in stats are of the vertices (edges, faces) shared by several
+// solids of the result. a failed fuse is logged and gives a null shape
+TopoDS_Shape
+fuse_glue_shape(
+	const TopoDS_Shape &shape, Standard_Real tolerance,
+	glue_stats *stats = nullptr,
+	const Message_ProgressRange &progress = Message_ProgressRange());
+
+// glue the solids of `shape` to each other and onto the solids of `fixed`
+// that are close to them. sub-shapes of `fixed` are reused rather than
+// rebuilt, so the rest of a previously glued model stays shared with them.
+// a vertex outside the tolerance of the fixed vertex it coincides with can't
+// be glued onto it without changing the fixed shape, so it and the edges and
+// faces on it are left unglued, counted in stats->num_unglued and warned
+// about. only the (glued) solids of `shape` are returned, in order
+TopoDS_Shape
+salome_glue_shape_onto(
+	const TopoDS_Shape &shape, const TopoDS_Shape &fixed, Standard_Real tolerance,
+	glue_stats *stats = nullptr,
+	const Message_ProgressRange &progress = Message_ProgressRange());
+
+#endif // GEOM_GLUER_HXX
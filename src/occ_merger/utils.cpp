@@ -3,6 +3,7 @@
 #include <cassert>
 
 #include <algorithm>
+#include <cmath>
 #include <iomanip>
 #include <limits>
 #include <sstream>
@@ -38,6 +39,16 @@ are_vals_close(const double a, const double b, const double drel, const double d
 	return std::abs(b - a) < (drel * mag + dabs);
 }
 
+unsigned
+millisecs_to_unsigned(const double millisecs)
+{
+	assert(millisecs >= 0);
+
+	const double rounded = std::ceil(millisecs);
+	constexpr unsigned largest = std::numeric_limits<unsigned>::max();
+	return rounded < (double)largest ? (unsigned)rounded : largest;
+}
+
 #ifdef INCLUDE_TESTS
 TEST_CASE("are_vals_close") {
 	SECTION("identical values") {
@@ -11,6 +11,10 @@ bool size_t_of_string (const char *s, size_t &i, int base=0);
 
 bool are_vals_close(double a, double b, double drel=1e-10, double dabs=1e-13);
 
+// milliseconds rounded up to a whole number, clamped to the largest unsigned
+// (about 49 days) rather than overflowing
+unsigned millisecs_to_unsigned(double millisecs);
+
 enum class input_status {
 	error,
 
@@ -1,13 +1,22 @@
 import pytest
 
 from fast_ctd import (
+    ImprintStatus,
+    IntersectStatus,
+    MergeCancelled,
+    benchmark_merge_engines,
+    check_brep_overlaps,
     check_watertight,
     dagmc_to_vtk,
     decode_tightness_checks,
+    detect_brep_merges,
     facet_brep_to_dagmc,
+    fix_brep_overlaps,
     make_watertight,
     merge_brep_geometries,
+    merge_brep_geometries_incremental,
     step_to_brep,
+    sweep_merge_tolerances,
 )
 
 
@@ -89,3 +98,571 @@ def test_make_and_check_watertight(
     assert all(p == 0 if is_wt else p != 0 for p in out_check_wt), (
         "check_watertight did not produce expected results"
     )
+
+
+@pytest.mark.parametrize("partitioned", [False, True])
+def test_merge_brep_geometries_modes(partitioned: bool, tmp_path, test_data_path):
+    # cube a shares a face with each of b and c, which share an edge
+    brep_file = tmp_path / "test_adjacent_cubes.brep"
+    merged_brep_file = tmp_path / "test_adjacent_cubes-merged.brep"
+
+    comps_info = step_to_brep(test_data_path / "test_adjacent_cubes.stp", brep_file)
+    stats = merge_brep_geometries(brep_file, merged_brep_file, partitioned=partitioned)
+
+    assert merged_brep_file.exists(), "Merged BREP file was not created"
+    assert merged_brep_file.stat().st_size > 0, "Merged BREP file is empty"
+
+    assert stats.num_vertices > 0, "No vertices were considered for merging"
+    # the corners of the two shared faces, two of which are on both
+    assert stats.num_vertex_clusters == 6
+    assert stats.num_face_groups == 2
+    assert stats.num_glued_faces == 4
+    # all three cubes touch, so are glued as one cluster either way
+    assert stats.num_clusters == 1
+    # the cubes are planes and lines, checked without projecting
+    assert stats.num_analytic_checks > 0
+    assert {p.name for p in stats.phases} >= {"detect vertices", "refine faces"}
+    assert all(p.seconds >= 0 for p in stats.phases)
+    assert stats.peak_memory_bytes >= max(p.memory_bytes for p in stats.phases)
+
+    # every solid is still there, in order, touching the others
+    pairs = check_brep_overlaps(merged_brep_file)
+    assert len(comps_info) == 3
+    assert [(p.a, p.b) for p in pairs] == [(0, 1), (0, 2), (1, 2)]
+    assert all(p.status == IntersectStatus.touching for p in pairs)
+
+
+def test_merge_brep_geometries_cross_solid_only(tmp_path, test_data_path):
+    brep_file = tmp_path / "test_cubes.brep"
+
+    step_to_brep(test_data_path / "test_cubes.stp", brep_file)
+    full = merge_brep_geometries(brep_file, tmp_path / "full.brep")
+    cross = merge_brep_geometries(
+        brep_file, tmp_path / "cross.brep", cross_solid_only=True
+    )
+
+    assert "map owners" in {p.name for p in cross.phases}
+    assert cross.num_glued_faces == full.num_glued_faces
+    assert cross.num_projections <= full.num_projections
+
+
+def test_merge_brep_geometries_near_misses(tmp_path, test_data_path):
+    brep_file = tmp_path / "test_cubes.brep"
+
+    step_to_brep(test_data_path / "test_cubes.stp", brep_file)
+    plain = merge_brep_geometries(brep_file, tmp_path / "plain.brep")
+    stats = merge_brep_geometries(
+        brep_file, tmp_path / "report.brep", near_miss_tolerance=1e3
+    )
+
+    assert not plain.near_misses
+    assert stats.near_misses, "No near misses were reported"
+    assert stats.num_glued_faces == plain.num_glued_faces
+    tolerances = [miss.tolerance for miss in stats.near_misses]
+    assert tolerances == sorted(tolerances)
+    for miss in stats.near_misses:
+        assert miss.type in {"vertex", "edge", "face"}
+        assert 0.001 <= miss.tolerance <= 1e3
+        assert miss.solids_a
+        assert miss.solids_b
+
+
+def test_merge_brep_geometries_near_miss_gap(tmp_path, test_data_path):
+    # the second cube is just short of touching the first, the third is far
+    # from both
+    brep_file = tmp_path / "test_gapped_cubes.brep"
+
+    step_to_brep(test_data_path / "test_gapped_cubes.stp", brep_file)
+    plain = merge_brep_geometries(
+        brep_file, tmp_path / "plain.brep", dist_tolerance=1e-5
+    )
+    stats = merge_brep_geometries(
+        brep_file,
+        tmp_path / "report.brep",
+        dist_tolerance=1e-5,
+        near_miss_tolerance=0.2,
+    )
+    partitioned = merge_brep_geometries(
+        brep_file,
+        tmp_path / "partitioned.brep",
+        dist_tolerance=1e-5,
+        partitioned=True,
+        near_miss_tolerance=0.2,
+    )
+
+    assert plain.num_glued_faces == 0
+    assert stats.num_glued_faces == 0
+    counts = {}
+    for miss in stats.near_misses:
+        counts[miss.type] = counts.get(miss.type, 0) + 1
+        assert 1e-5 < miss.tolerance <= 0.2
+        assert miss.solids_a == [0]
+        assert miss.solids_b == [1]
+    assert counts == {"vertex": 4, "edge": 4, "face": 1}
+
+    def summary(result):
+        return sorted(
+            (miss.type, miss.solids_a, miss.solids_b) for miss in result.near_misses
+        )
+
+    assert summary(partitioned) == summary(stats)
+
+
+def test_merge_brep_geometries_fuse_engine(tmp_path, test_data_path):
+    brep_file = tmp_path / "test_adjacent_cubes.brep"
+    merged_brep_file = tmp_path / "test_adjacent_cubes-merged.brep"
+
+    step_to_brep(test_data_path / "test_adjacent_cubes.stp", brep_file)
+    stats = merge_brep_geometries(brep_file, merged_brep_file, engine="fuse")
+
+    assert merged_brep_file.exists(), "Merged BREP file was not created"
+    assert "general fuse" in {p.name for p in stats.phases}
+    assert stats.num_face_groups == 2, "Faces aren't shared between solids"
+
+
+def test_benchmark_merge_engines(tmp_path, test_data_path):
+    brep_file = tmp_path / "test_adjacent_cubes.brep"
+
+    step_to_brep(test_data_path / "test_adjacent_cubes.stp", brep_file)
+    runs = benchmark_merge_engines(brep_file)
+
+    assert [run.engine for run in runs] == ["salome", "fuse"]
+    for run in runs:
+        assert run.passed, f"{run.engine} engine failed its checks"
+        assert run.seconds >= 0
+        assert run.stats.num_face_groups == 2
+
+
+def test_benchmark_merge_engines_failure(tmp_path, test_data_path):
+    brep_file = tmp_path / "test_overlapping_cubes.brep"
+
+    # the fuse splits overlapping cubes, which fails its checks rather than
+    # ending the benchmark
+    step_to_brep(test_data_path / "test_overlapping_cubes.stp", brep_file)
+    runs = benchmark_merge_engines(brep_file)
+
+    assert [run.engine for run in runs] == ["salome", "fuse"]
+    assert not runs[1].passed
+
+
+def test_merge_brep_geometries_grouped(tmp_path, test_data_path):
+    brep_file = tmp_path / "test_adjacent_cubes.brep"
+    merged_brep_file = tmp_path / "test_adjacent_cubes-merged.brep"
+    single_brep_file = tmp_path / "test_adjacent_cubes-single.brep"
+
+    step_to_brep(test_data_path / "test_adjacent_cubes.stp", brep_file)
+    # the first two cubes are glued within their group, the third across
+    stats = merge_brep_geometries(brep_file, merged_brep_file, groups=[0, 0, 1])
+    single = merge_brep_geometries(brep_file, single_brep_file)
+
+    assert merged_brep_file.exists(), "Merged BREP file was not created"
+    assert stats.num_vertex_clusters > 0, "No coincident vertices were found"
+
+    # shares everything a single pass does
+    for merged in (merged_brep_file, single_brep_file):
+        detection = detect_brep_merges(merged)
+        assert not detection.vertices + detection.edges + detection.faces
+    pairs = check_brep_overlaps(merged_brep_file)
+    single_pairs = check_brep_overlaps(single_brep_file)
+    assert [(p.a, p.b, p.status) for p in pairs] == [(p.a, p.b, p.status) for p in single_pairs]
+    assert single.num_face_groups == 2
+
+
+def test_merge_brep_geometries_imprint(tmp_path, test_data_path):
+    brep_file = tmp_path / "test_cubes.brep"
+    merged_brep_file = tmp_path / "test_cubes-merged.brep"
+
+    step_to_brep(test_data_path / "test_cubes.stp", brep_file)
+    stats = merge_brep_geometries(brep_file, merged_brep_file, imprint=True)
+
+    assert merged_brep_file.exists(), "Merged BREP file was not created"
+    assert "imprint" in {p.name for p in stats.phases}
+
+
+def test_merge_in_mesh_space(tmp_path, test_data_path):
+    brep_file = tmp_path / "test_adjacent_cubes.brep"
+    merged_brep_file = tmp_path / "test_adjacent_cubes-merged.brep"
+    materials_csv_file = test_data_path / "test_adjacent_cubes-mats.csv"
+
+    comps_info = step_to_brep(test_data_path / "test_adjacent_cubes.stp", brep_file)
+    all_solids = list(range(len(comps_info)))
+    stats = merge_brep_geometries(brep_file, merged_brep_file, mesh_solids=all_solids)
+
+    assert stats.mesh_solids == all_solids
+    assert stats.num_glued_faces == 0, "Solids left for mesh merging were glued"
+
+    def count_cells(mesh_merge_solids: list[int]) -> int:
+        name = "merged" if mesh_merge_solids else "unmerged"
+        output_dagmc_file = tmp_path / f"{name}.h5m"
+        output_vtk_file = tmp_path / f"{name}.vtk"
+        facet_brep_to_dagmc(
+            merged_brep_file,
+            output_h5m_file=output_dagmc_file,
+            materials_csv_file=materials_csv_file,
+            mesh_merge_solids=mesh_merge_solids,
+        )
+        assert output_dagmc_file.exists(), "DAGMC file was not created"
+        dagmc_to_vtk(output_dagmc_file, output_vtk_file)
+        for line in output_vtk_file.read_text().splitlines():
+            if line.startswith("CELLS"):
+                return int(line.split()[1])
+        pytest.fail("No cells in the DAGMC VTK file")
+
+    # the two shared faces, and their edges, are only triangulated once
+    assert count_cells(stats.mesh_solids) < count_cells([])
+
+
+def test_merge_in_mesh_space_curved(tmp_path, test_data_path):
+    brep_file = tmp_path / "test_cylinder_in_tube.brep"
+    merged_brep_file = tmp_path / "test_cylinder_in_tube-merged.brep"
+    output_dagmc_file = tmp_path / "test_cylinder_in_tube.h5m"
+    materials_csv_file = test_data_path / "test_cylinder_in_tube-mats.csv"
+
+    comps_info = step_to_brep(test_data_path / "test_cylinder_in_tube.stp", brep_file)
+    all_solids = list(range(len(comps_info)))
+    stats = merge_brep_geometries(brep_file, merged_brep_file, mesh_solids=all_solids)
+
+    # the cylinder and the inside of the tube are faceted separately, and
+    # their circles needn't be discretized alike
+    facet_brep_to_dagmc(
+        merged_brep_file,
+        output_h5m_file=output_dagmc_file,
+        materials_csv_file=materials_csv_file,
+        mesh_merge_solids=stats.mesh_solids,
+    )
+    assert output_dagmc_file.exists(), "DAGMC file was not created"
+
+    sp_check_wt = check_watertight(output_dagmc_file)
+    assert sp_check_wt.returncode == 0, "check_watertight failed"
+    out_check_wt = decode_tightness_checks(sp_check_wt.stdout)
+    assert out_check_wt is not None, (
+        "Failed to decode tightness checks on check_watertight"
+    )
+    assert all(p == 0 for p in out_check_wt), "Mesh merged interface is not watertight"
+
+
+def test_check_brep_overlaps(tmp_path, test_data_path):
+    brep_file = tmp_path / "test_cubes.brep"
+
+    step_to_brep(test_data_path / "test_cubes.stp", brep_file)
+    pairs = check_brep_overlaps(brep_file)
+
+    assert pairs, "No touching solids were found"
+    assert [(p.a, p.b) for p in pairs] == sorted((p.a, p.b) for p in pairs)
+    assert all(p.a < p.b for p in pairs)
+    # the cubes share faces
+    assert any(p.status == IntersectStatus.touching for p in pairs)
+    assert all(p.seconds >= 0 for p in pairs)
+
+
+@pytest.mark.parametrize("concurrent", [False, True])
+def test_check_brep_overlaps_retries(tmp_path, test_data_path, concurrent):
+    brep_file = tmp_path / "test_cubes.brep"
+
+    step_to_brep(test_data_path / "test_cubes.stp", brep_file)
+    ladder = [0.01, 0.0001]
+    pairs = check_brep_overlaps(
+        brep_file,
+        fuzzy_value=0.001,
+        retry_fuzzy_values=ladder,
+        concurrent_retries=concurrent,
+    )
+
+    # the cubes classify at once, so nothing is retried. timed out first
+    # attempts are covered by test_check_brep_overlaps_retries_timeout
+    assert pairs, "No touching solids were found"
+    for p in pairs:
+        assert p.status not in (IntersectStatus.failed, IntersectStatus.timeout)
+        assert p.attempts == 1
+        assert p.fuzzy_value == pytest.approx(0.001)
+
+
+@pytest.mark.parametrize("concurrent", [False, True])
+def test_check_brep_overlaps_retries_timeout(tmp_path, test_data_path, concurrent):
+    brep_file = tmp_path / "test_cylinder_in_tube.brep"
+
+    step_to_brep(test_data_path / "test_cylinder_in_tube.stp", brep_file)
+    # paving coincident cylinders takes far longer than a millisecond, so the
+    # first attempt times out. the retry's limit grows past what a count of
+    # milliseconds can hold, and is clamped rather than wrapping round
+    pairs = check_brep_overlaps(
+        brep_file,
+        fuzzy_value=0.001,
+        pave_time_limit=1e-6,
+        retry_fuzzy_values=[0.01],
+        retry_timeout_factor=1e12,
+        concurrent_retries=concurrent,
+    )
+
+    assert [(p.a, p.b) for p in pairs] == [(0, 1)]
+    (pair,) = pairs
+    assert pair.attempts == 2
+    assert pair.status == IntersectStatus.touching
+    assert pair.fuzzy_value == pytest.approx(0.01)
+
+
+def test_check_brep_overlaps_cached(tmp_path, test_data_path):
+    brep_file = tmp_path / "test_overlapping_cubes.brep"
+    moved_brep_file = tmp_path / "test_moved_cubes.brep"
+    moved_step_file = tmp_path / "test_moved_cubes.stp"
+    cache_dir = tmp_path / "cache"
+
+    step_to_brep(test_data_path / "test_overlapping_cubes.stp", brep_file)
+    first = check_brep_overlaps(brep_file, cache_dir=cache_dir)
+    assert (cache_dir / "pairs.txt").exists(), "Cache index was not written"
+    assert first, "No touching solids were found"
+    assert not any(p.cached for p in first)
+
+    second = check_brep_overlaps(brep_file, cache_dir=cache_dir)
+    assert [(p.a, p.b, p.status) for p in second] == [
+        (p.a, p.b, p.status) for p in first
+    ]
+    assert all(p.cached for p in second)
+    for p, q in zip(first, second, strict=True):
+        assert q.vol_common == pytest.approx(p.vol_common)
+
+    # moving the last cube changes its pairs, but not the first
+    step = (test_data_path / "test_overlapping_cubes.stp").read_text()
+    moved_step_file.write_text(
+        step.replace(
+            "#24 = CARTESIAN_POINT('',(1.,0.,0.));",
+            "#24 = CARTESIAN_POINT('',(1.2,0.,0.));",
+        )
+    )
+    step_to_brep(moved_step_file, moved_brep_file)
+    moved = check_brep_overlaps(moved_brep_file, cache_dir=cache_dir)
+    assert {(p.a, p.b): p.cached for p in moved} == {(0, 1): True, (1, 2): False}
+    # and the result of the pair before it moved is dropped
+    index = (cache_dir / "pairs.txt").read_text().splitlines()
+    assert len([line for line in index if line.startswith("intersect ")]) == len(
+        moved
+    )
+
+
+def test_fix_brep_overlaps_cached(tmp_path, test_data_path):
+    brep_file = tmp_path / "test_overlapping_cubes.brep"
+    cache_dir = tmp_path / "cache"
+
+    step_to_brep(test_data_path / "test_overlapping_cubes.stp", brep_file)
+    first = fix_brep_overlaps(
+        brep_file, tmp_path / "first.brep", cache_dir=cache_dir
+    )
+    second = fix_brep_overlaps(
+        brep_file, tmp_path / "second.brep", cache_dir=cache_dir
+    )
+
+    assert len(first) == len(second) == 2
+    # the first round's imprint comes from classifying, the second's is
+    # computed. both are found in the cache the next time
+    assert not any(fix.cached for fix in first)
+    assert all(fix.cached for fix in second)
+    for fix, again in zip(first, second, strict=True):
+        assert again.status == fix.status
+        assert again.vol_common == pytest.approx(fix.vol_common)
+    # a shapes file for each imprint that didn't fail, and nothing else
+    imprints = [
+        line.split()
+        for line in (cache_dir / "pairs.txt").read_text().splitlines()
+        if line.startswith("imprint ")
+    ]
+    assert {path.stem for path in cache_dir.glob("*.brep")} == {
+        fields[1] for fields in imprints if fields[2] != "0"
+    }
+
+
+def test_fix_brep_overlaps(tmp_path, test_data_path):
+    brep_file = tmp_path / "test_overlapping_cubes.brep"
+    fixed_brep_file = tmp_path / "test_overlapping_cubes-fixed.brep"
+
+    comps_info = step_to_brep(test_data_path / "test_overlapping_cubes.stp", brep_file)
+    fixes = fix_brep_overlaps(brep_file, fixed_brep_file)
+
+    assert fixed_brep_file.exists(), "Fixed BREP file was not created"
+    # the middle cube overlaps both others, so they take two rounds
+    assert [(fix.a, fix.b) for fix in fixes] == [(0, 1), (1, 2)]
+    assert sorted(fix.round for fix in fixes) == [0, 1]
+    for fix in fixes:
+        assert fix.a < fix.b < len(comps_info)
+        assert fix.status != ImprintStatus.failed
+        assert fix.vol_common > 0
+    # no solid is resolved twice in one round
+    for rnd in {fix.round for fix in fixes}:
+        solids = [s for fix in fixes if fix.round == rnd for s in (fix.a, fix.b)]
+        assert len(solids) == len(set(solids))
+
+    pairs = check_brep_overlaps(fixed_brep_file)
+    assert not any(p.status == IntersectStatus.overlap for p in pairs)
+
+
+def test_detect_brep_merges(tmp_path, test_data_path):
+    brep_file = tmp_path / "test_adjacent_cubes.brep"
+
+    comps_info = step_to_brep(test_data_path / "test_adjacent_cubes.stp", brep_file)
+    detection = detect_brep_merges(brep_file)
+
+    # the same groups a merge would glue
+    assert len(detection.vertices) == 6
+    assert len(detection.edges) == 7
+    assert len(detection.faces) == 2
+    for group in detection.vertices + detection.edges + detection.faces:
+        assert group.size > 1
+        assert group.solids == sorted(set(group.solids))
+        assert all(0 <= idx < len(comps_info) for idx in group.solids)
+
+
+def test_sweep_merge_tolerances(tmp_path, test_data_path):
+    brep_file = tmp_path / "test_adjacent_cubes.brep"
+    merged_brep_file = tmp_path / "test_adjacent_cubes-merged.brep"
+
+    step_to_brep(test_data_path / "test_adjacent_cubes.stp", brep_file)
+
+    tolerances = [1e-6, 1e-3, 1e-1]
+    sweep = sweep_merge_tolerances(
+        brep_file,
+        tolerances,
+        output_brep_file=merged_brep_file,
+        output_dist_tolerance=1e-3,
+    )
+    assert len(sweep) == len(tolerances)
+    assert merged_brep_file.exists(), "Merged BREP file was not created"
+
+    # matches a merge at the same tolerance
+    stats = merge_brep_geometries(brep_file, tmp_path / "direct.brep", dist_tolerance=1e-3)
+    assert sweep[1].num_vertex_clusters == stats.num_vertex_clusters == 6
+    assert sweep[1].num_face_groups == stats.num_face_groups == 2
+    assert sweep[1].num_glued_vertices == stats.num_glued_vertices
+    assert all(s.num_vertices == stats.num_vertices for s in sweep)
+
+    # a larger tolerance glues at least as much
+    counts = [s.num_glued_vertices for s in sweep]
+    assert counts == sorted(counts)
+
+
+def test_merge_brep_geometries_cancelled(tmp_path, test_data_path):
+    brep_file = tmp_path / "test_cubes.brep"
+    merged_brep_file = tmp_path / "test_cubes-merged.brep"
+
+    step_to_brep(test_data_path / "test_cubes.stp", brep_file)
+
+    reports = []
+
+    def cancel(phase: str, fraction: float) -> bool:
+        reports.append((phase, fraction))
+        return False
+
+    with pytest.raises(MergeCancelled):
+        merge_brep_geometries(brep_file, merged_brep_file, progress=cancel)
+
+    assert reports, "Progress callback was never called"
+    assert not merged_brep_file.exists(), "Cancelled merge wrote an output file"
+
+
+def test_merge_brep_geometries_callback_raises(tmp_path, test_data_path):
+    brep_file = tmp_path / "test_cubes.brep"
+    merged_brep_file = tmp_path / "test_cubes-merged.brep"
+
+    step_to_brep(test_data_path / "test_cubes.stp", brep_file)
+
+    class CallbackError(Exception):
+        pass
+
+    def fail(phase: str, fraction: float) -> bool:
+        raise CallbackError(phase)
+
+    # the callback's own exception reaches the caller, rather than exiting
+    with pytest.raises(CallbackError):
+        merge_brep_geometries(brep_file, merged_brep_file, progress=fail)
+
+    assert not merged_brep_file.exists(), "Cancelled merge wrote an output file"
+
+
+def test_merge_brep_geometries_long_time_limit(tmp_path, test_data_path):
+    brep_file = tmp_path / "test_cubes.brep"
+    merged_brep_file = tmp_path / "test_cubes-merged.brep"
+
+    step_to_brep(test_data_path / "test_cubes.stp", brep_file)
+
+    # too long to hold in milliseconds, so clamped rather than wrapping round
+    # to a tiny limit
+    merge_brep_geometries(brep_file, merged_brep_file, time_limit=1e10)
+    assert merged_brep_file.exists(), "Merged BREP file was not created"
+
+
+def test_merge_brep_geometries_incremental(tmp_path, test_data_path):
+    brep_file = tmp_path / "test_adjacent_cubes.brep"
+    merged_brep_file = tmp_path / "test_adjacent_cubes-merged.brep"
+    remerged_brep_file = tmp_path / "test_adjacent_cubes-remerged.brep"
+
+    comps_info = step_to_brep(test_data_path / "test_adjacent_cubes.stp", brep_file)
+    merge_brep_geometries(brep_file, merged_brep_file)
+
+    # replacing every solid with its unmerged geometry is a full re-merge
+    stats = merge_brep_geometries_incremental(
+        merged_brep_file,
+        brep_file,
+        list(range(len(comps_info))),
+        remerged_brep_file,
+    )
+
+    assert remerged_brep_file.exists(), "Re-merged BREP file was not created"
+    assert remerged_brep_file.stat().st_size > 0, "Re-merged BREP file is empty"
+    assert stats.num_face_groups == 2
+
+    # coincident vertices, edges and faces are shared again, so there's
+    # nothing left to merge
+    assert detect_brep_merges(brep_file).faces
+    for path in (merged_brep_file, remerged_brep_file):
+        detection = detect_brep_merges(path)
+        assert not detection.vertices
+        assert not detection.edges
+        assert not detection.faces
+
+
+def test_merge_brep_geometries_incremental_partial(tmp_path, test_data_path):
+    brep_file = tmp_path / "test_adjacent_cubes.brep"
+    merged_brep_file = tmp_path / "test_adjacent_cubes-merged.brep"
+    cube_brep_file = tmp_path / "cube_b.brep"
+    moved_step_file = tmp_path / "moved_cube_b.stp"
+    moved_brep_file = tmp_path / "moved_cube_b.brep"
+
+    step_to_brep(test_data_path / "test_adjacent_cubes.stp", brep_file)
+    merge_brep_geometries(brep_file, merged_brep_file, dist_tolerance=0.1)
+
+    # the second cube as it was glues back onto the face it shares with the
+    # first and the edge it shares with the third
+    step_to_brep(test_data_path / "test_adjacent_cube_b.stp", cube_brep_file)
+    stats = merge_brep_geometries_incremental(
+        merged_brep_file,
+        cube_brep_file,
+        [1],
+        tmp_path / "same.brep",
+        dist_tolerance=0.1,
+    )
+    assert stats.num_face_groups == 1
+    assert stats.num_unglued == 0
+    detection = detect_brep_merges(tmp_path / "same.brep", dist_tolerance=0.1)
+    assert not detection.vertices
+    assert not detection.edges
+    assert not detection.faces
+
+    # moved within the merge tolerance, but outside the tolerances of the
+    # vertices it shares, which can't grow without changing the other cubes
+    step = (test_data_path / "test_adjacent_cube_b.stp").read_text()
+    moved_step_file.write_text(
+        step.replace(
+            "#20 = CARTESIAN_POINT('',(1.,0.,0.));",
+            "#20 = CARTESIAN_POINT('',(1.00001,0.,0.));",
+        )
+    )
+    step_to_brep(moved_step_file, moved_brep_file)
+    stats = merge_brep_geometries_incremental(
+        merged_brep_file,
+        moved_brep_file,
+        [1],
+        tmp_path / "moved.brep",
+        dist_tolerance=0.1,
+    )
+    assert stats.num_unglued > 0
+    assert (tmp_path / "moved.brep").exists()
+    detection = detect_brep_merges(tmp_path / "moved.brep", dist_tolerance=0.1)
+    assert detection.faces